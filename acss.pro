@@ -2,7 +2,9 @@ TEMPLATE = subdirs
 
 SUBDIRS = \
 	src \
+	tools \
 	examples
 
 #demo.depends = src
-examples.depends = src
\ No newline at end of file
+tools.depends = src
+examples.depends = src tools
@@ -0,0 +1,26 @@
+# Compiles the style folders listed in ACSS_COMPILED_STYLES with the
+# acss_stylec tool into C++ sources and adds them to SOURCES. Each style
+# defines the variable <style folder>_style - for the style folder
+# qt_material you can use it via ACSS_DECLARE_COMPILED_STYLE(qt_material_style).
+# ACSS_OUT_ROOT needs to be set to the build root of the library:
+#
+#   ACSS_COMPILED_STYLES += $$PWD/../../styles/qt_material
+#   include(../../acss_stylec.pri)
+
+ACSS_STYLEC = $${ACSS_OUT_ROOT}/lib/acss_stylec
+win32: ACSS_STYLEC = $${ACSS_STYLEC}.exe
+
+# Changes of any style file trigger a recompilation of the style
+for(style, ACSS_COMPILED_STYLES) {
+    for(pattern, $$list(*.json *.xml *.svg *.template *.ttf)) {
+        ACSS_COMPILED_STYLE_FILES += $$files($${style}/$${pattern}, true)
+    }
+}
+
+acss_stylec.input = ACSS_COMPILED_STYLES
+acss_stylec.output = ${QMAKE_FILE_BASE}_compiled_style.cpp
+acss_stylec.commands = $$shell_path($$ACSS_STYLEC) ${QMAKE_FILE_NAME} ${QMAKE_FILE_OUT}
+acss_stylec.depends = $$ACSS_STYLEC $$ACSS_COMPILED_STYLE_FILES
+acss_stylec.variable_out = SOURCES
+acss_stylec.name = acss_stylec ${QMAKE_FILE_IN}
+QMAKE_EXTRA_COMPILERS += acss_stylec
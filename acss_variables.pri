@@ -0,0 +1,30 @@
+# Generates a header with typed ids for the theme variables of the style
+# folders listed in ACSS_VARIABLE_STYLES with the acss_stylec tool. For the
+# style folder qt_material, the header qt_material_variables.h defines the
+# ids in the namespace qt_material_variables. Call
+# qt_material_variables::registerVariableIds() once and use the ids with
+# QtAdvancedStylesheet::themeColorById().
+# ACSS_OUT_ROOT needs to be set to the build root of the library:
+#
+#   ACSS_VARIABLE_STYLES += $$PWD/../../styles/qt_material
+#   include(../../acss_variables.pri)
+
+ACSS_STYLEC = $${ACSS_OUT_ROOT}/lib/acss_stylec
+win32: ACSS_STYLEC = $${ACSS_STYLEC}.exe
+
+# New variables or theme colors trigger a regeneration of the header
+for(style, ACSS_VARIABLE_STYLES) {
+    for(pattern, $$list(*.json *.xml)) {
+        ACSS_VARIABLE_STYLE_FILES += $$files($${style}/$${pattern}, true)
+    }
+}
+
+acss_variables.input = ACSS_VARIABLE_STYLES
+acss_variables.output = ${QMAKE_FILE_BASE}_variables.h
+acss_variables.commands = $$shell_path($$ACSS_STYLEC) --variables-header ${QMAKE_FILE_NAME} ${QMAKE_FILE_OUT}
+acss_variables.depends = $$ACSS_STYLEC $$ACSS_VARIABLE_STYLE_FILES
+acss_variables.variable_out = HEADERS
+acss_variables.CONFIG += target_predeps no_link
+acss_variables.name = acss_variables ${QMAKE_FILE_IN}
+QMAKE_EXTRA_COMPILERS += acss_variables
+INCLUDEPATH += $$OUT_PWD
@@ -0,0 +1,31 @@
+ACSS_OUT_ROOT = $${OUT_PWD}/../..
+
+QT += core gui widgets
+
+TARGET = compiled_style
+DESTDIR = $${ACSS_OUT_ROOT}/lib
+TEMPLATE = app
+
+CONFIG += c++14
+CONFIG += debug_and_release
+
+acssBuildStatic {
+    DEFINES += ACSS_STATIC
+}
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += main.cpp
+
+# The style is compiled into the binary - there is no STYLES_DIR
+ACSS_COMPILED_STYLES += $$PWD/../../styles/qt_material
+include(../../acss_stylec.pri)
+
+# Typed ids for the theme variables of the style
+ACSS_VARIABLE_STYLES += $$PWD/../../styles/qt_material
+include(../../acss_variables.pri)
+
+LIBS += -L$${ACSS_OUT_ROOT}/lib
+include(../../acss.pri)
+INCLUDEPATH += ../../src
+DEPENDPATH += ../../src
@@ -0,0 +1,84 @@
+#include <QtAdvancedStylesheet.h>
+#include <CompiledStyle.h>
+#include <QApplication>
+#include <QComboBox>
+#include <QCheckBox>
+#include <QPushButton>
+#include <QVBoxLayout>
+#include <QDir>
+#include <QPainter>
+
+#include "qt_material_variables.h"
+
+using namespace acss;
+
+// Generated by acss_stylec from styles/qt_material
+ACSS_DECLARE_COMPILED_STYLE(qt_material_style)
+
+/**
+ * Custom painted widget that uses the typed variable ids in its paintEvent
+ */
+class CColorSwatch : public QWidget
+{
+public:
+    CColorSwatch(QtAdvancedStylesheet& AdvancedStylesheet)
+        : m_AdvancedStylesheet(AdvancedStylesheet)
+    {
+        setMinimumHeight(24);
+    }
+
+protected:
+    void paintEvent(QPaintEvent*) override
+    {
+        using namespace qt_material_variables;
+        QPainter Painter(this);
+        const int Width = width() / 3;
+        Painter.fillRect(0, 0, Width, height(), m_AdvancedStylesheet.themeColorById(primaryColor));
+        Painter.fillRect(Width, 0, Width, height(), m_AdvancedStylesheet.themeColorById(primaryLightColor));
+        Painter.fillRect(2 * Width, 0, width() - 2 * Width, height(),
+            m_AdvancedStylesheet.themeColorById(secondaryColor));
+    }
+
+private:
+    QtAdvancedStylesheet& m_AdvancedStylesheet;
+};
+
+int main(int argc, char *argv[])
+{
+    QApplication a(argc, argv);
+    QWidget Window;
+    auto Layout = new QVBoxLayout(&Window);
+    auto ThemeComboBox = new QComboBox();
+    Layout->addWidget(ThemeComboBox);
+    Layout->addWidget(new QCheckBox("Check Box"));
+    Layout->addWidget(new QPushButton("Push Button"));
+
+    // The style is loaded from the tables compiled into the binary. Only the
+    // generated resources are written to the output dir.
+    QtAdvancedStylesheet AdvancedStylesheet;
+    qt_material_variables::registerVariableIds(AdvancedStylesheet);
+    Layout->addWidget(new CColorSwatch(AdvancedStylesheet));
+    AdvancedStylesheet.setOutputDirPath(QDir::tempPath() + "/acss_compiled_style");
+    AdvancedStylesheet.setCurrentStyle(qt_material_style);
+    AdvancedStylesheet.setDefaultTheme();
+    AdvancedStylesheet.updateStylesheet();
+    a.setStyleSheet(AdvancedStylesheet.styleSheet());
+    Window.setWindowIcon(AdvancedStylesheet.styleIcon());
+
+    ThemeComboBox->addItems(AdvancedStylesheet.themes());
+    ThemeComboBox->setCurrentText(AdvancedStylesheet.currentTheme());
+    QObject::connect(ThemeComboBox, &QComboBox::currentTextChanged,
+        [&](const QString& Theme)
+        {
+            AdvancedStylesheet.setCurrentTheme(Theme);
+            AdvancedStylesheet.updateStylesheet();
+        });
+    QObject::connect(&AdvancedStylesheet, &QtAdvancedStylesheet::stylesheetChanged,
+        [&]()
+        {
+            a.setStyleSheet(AdvancedStylesheet.styleSheet());
+        });
+
+    Window.show();
+    return a.exec();
+}
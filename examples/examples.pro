@@ -2,4 +2,9 @@ TEMPLATE = subdirs
 
 SUBDIRS = \
     exporter \
-    full_features
+    compiled_style \
+    theme_switch_benchmark \
+    soak_test
+
+# The full features example shows the QML support
+!acssNoQml: SUBDIRS += full_features
@@ -1,6 +1,9 @@
 #include <QtAdvancedStylesheet.h>
+#include <StylesheetAnalyzer.h>
 #include <QCoreApplication>
 #include <QDir>
+#include <QFile>
+#include <QJsonObject>
 
 #include <iostream>
 
@@ -19,4 +22,57 @@ int main(int argc, char *argv[])
     AdvancedStylesheet.setOutputDirPath(AppDir + "/output");
     AdvancedStylesheet.setCurrentStyle("qt_material");
     AdvancedStylesheet.setCurrentTheme("dark_teal");
+
+    // Optimizes the SVG resources and prints the size savings
+    if (a.arguments().contains("--optimize-svg"))
+    {
+        AdvancedStylesheet.setSvgOptimizationEnabled(true);
+        if (!AdvancedStylesheet.generateResources())
+        {
+            std::cerr << AdvancedStylesheet.errorString().toStdString() << std::endl;
+            return 1;
+        }
+        std::cout << AdvancedStylesheet.svgOptimizationStatistics().toString().toStdString()
+            << std::endl;
+    }
+
+    // Prints the complexity report of the generated stylesheet. The optional
+    // limits let a build fail if a template change adds expensive patterns.
+    const auto Args = a.arguments();
+    if (Args.contains("--analyze"))
+    {
+        int MaxUniversalSelectors = -1;
+        int MaxBytes = -1;
+        for (int i = 1; i < Args.size() - 1; ++i)
+        {
+            if (Args[i] == "--max-universal-selectors") MaxUniversalSelectors = Args[++i].toInt();
+            else if (Args[i] == "--max-bytes") MaxBytes = Args[++i].toInt();
+        }
+
+        // The template is processed directly because updateStylesheet()
+        // requires a QApplication to update the palette
+        QFile TemplateFile(AdvancedStylesheet.currentStylePath() + "/"
+            + AdvancedStylesheet.styleParameters().value("css_template").toString());
+        if (!TemplateFile.open(QIODevice::ReadOnly))
+        {
+            std::cerr << "Reading " << TemplateFile.fileName().toStdString()
+                << " failed" << std::endl;
+            return 1;
+        }
+        CStylesheetAnalyzer Analyzer;
+        const auto& Stats = Analyzer.analyze(AdvancedStylesheet.processStylesheetTemplate(
+            QString::fromUtf8(TemplateFile.readAll())));
+        std::cout << Analyzer.report().toStdString() << std::endl;
+        if (MaxUniversalSelectors >= 0 && Stats.UniversalSelectors > MaxUniversalSelectors)
+        {
+            std::cerr << "Universal selectors: " << Stats.UniversalSelectors
+                << " > " << MaxUniversalSelectors << std::endl;
+            return 1;
+        }
+        if (MaxBytes >= 0 && Stats.Bytes > MaxBytes)
+        {
+            std::cerr << "Stylesheet size: " << Stats.Bytes << " > " << MaxBytes << std::endl;
+            return 1;
+        }
+    }
 }
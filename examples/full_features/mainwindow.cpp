@@ -2,6 +2,8 @@
 
 #include <QtAdvancedStylesheet.h>
 #include <QmlStyleUrlInterceptor.h>
+#include <QmlStyleImageProvider.h>
+#include <QmlStyleTheme.h>
 
 #include "ui_mainwindow.h"
 #include <QDir>
@@ -14,6 +16,7 @@
 #include <QColorDialog>
 #include <QDebug>
 #include <QQmlEngine>
+#include <QQmlContext>
 
 #include <iostream>
 
@@ -90,10 +93,8 @@ void MainWindowPrivate::updateThemeColorButtons()
 
 void MainWindowPrivate::updateQuickWidget()
 {
-	const auto Source = ui.quickWidget->source();
-	ui.quickWidget->setSource({});
-	ui.quickWidget->engine()->clearComponentCache();
-	ui.quickWidget->setSource(Source);
+	// The QML scene binds to the Theme object, so there is no need to
+	// reload it
 	ui.quickWidget->setStyleSheet(AdvancedStyleSheet->styleSheet());
 }
 
@@ -125,13 +126,19 @@ void MainWindowPrivate::setSomeIcons()
 
 void MainWindowPrivate::setupQuickWidget()
 {
+    // The image provider serves the icons from memory - the QML engine
+    // takes ownership of the provider
+    auto UrlInterceptor = new acss::CQmlStyleUrlInterceptor(AdvancedStyleSheet);
+    UrlInterceptor->setImageProviderId("acss");
+    ui.quickWidget->engine()->addImageProvider("acss",
+        new acss::CQmlStyleImageProvider(AdvancedStyleSheet));
 #if (QT_VERSION > QT_VERSION_CHECK(6,0,0))
-    ui.quickWidget->engine()->addUrlInterceptor(
-        new acss::CQmlStyleUrlInterceptor(AdvancedStyleSheet));
+    ui.quickWidget->engine()->addUrlInterceptor(UrlInterceptor);
 #else
-    ui.quickWidget->engine()->setUrlInterceptor(
-        new acss::CQmlStyleUrlInterceptor(AdvancedStyleSheet));
+    ui.quickWidget->engine()->setUrlInterceptor(UrlInterceptor);
 #endif
+    ui.quickWidget->rootContext()->setContextProperty("Theme",
+        new acss::CQmlStyleTheme(AdvancedStyleSheet, ui.quickWidget));
     ui.quickWidget->setStyleSheet(AdvancedStyleSheet->styleSheet());
     ui.quickWidget->setSource(QUrl("qrc:/full_features/qml/simple_demo.qml"));
     ui.quickWidget->setAttribute(Qt::WA_AlwaysStackOnTop);
@@ -160,9 +167,10 @@ CMainWindow::CMainWindow(QWidget *parent)
     d->AdvancedStyleSheet = new acss::QtAdvancedStylesheet(this);
     d->AdvancedStyleSheet->setStylesDirPath(StylesDir);
     d->AdvancedStyleSheet->setOutputDirPath(AppDir + "/output");
+    d->AdvancedStyleSheet->beginTransaction();
     d->AdvancedStyleSheet->setCurrentStyle("qt_material");
     d->AdvancedStyleSheet->setDefaultTheme();
-    d->AdvancedStyleSheet->updateStylesheet();
+    d->AdvancedStyleSheet->commitTransaction();
     setWindowIcon(d->AdvancedStyleSheet->styleIcon());
     qApp->setStyleSheet(d->AdvancedStyleSheet->styleSheet());
     connect(d->AdvancedStyleSheet, SIGNAL(stylesheetChanged()), this,
@@ -203,12 +211,23 @@ void CMainWindow::onThemeColorButtonClicked()
 	QColorDialog ColorDialog;
 	auto Color = d->AdvancedStyleSheet->themeColor(Button->text());
 	ColorDialog.setCurrentColor(Color);
+
+	// The live preview tracks the color picker while the dialog is open
+	auto AdvancedStyleSheet = d->AdvancedStyleSheet;
+	const auto VariableId = Button->text();
+	AdvancedStyleSheet->beginLivePreview();
+	connect(&ColorDialog, &QColorDialog::currentColorChanged,
+		[AdvancedStyleSheet, VariableId](const QColor& Color)
+		{
+			AdvancedStyleSheet->setLivePreviewVariable(VariableId, Color.name());
+		});
 	if (ColorDialog.exec() != QDialog::Accepted)
 	{
+		AdvancedStyleSheet->cancelLivePreview();
 		return;
 	}
 	Color = ColorDialog.currentColor();
-	d->AdvancedStyleSheet->setThemeVariableValue(Button->text(), Color.name());
-	d->AdvancedStyleSheet->updateStylesheet();
+	AdvancedStyleSheet->setLivePreviewVariable(VariableId, Color.name());
+	AdvancedStyleSheet->commitLivePreview();
 }
 
@@ -9,8 +9,6 @@ Page {
         color: "transparent"
     }
 
-    property SystemPalette systemPalette: SystemPalette {}
-
     Column {
         CheckBox {
             id: checkBox
@@ -23,7 +21,7 @@ Page {
 
                 verticalAlignment: Text.AlignVCenter
                 leftPadding: checkBox.indicator.width + checkBox.spacing
-                color: systemPalette.text
+                color: Theme.secondaryTextColor
             }
 
             indicator: Rectangle {
@@ -33,9 +31,9 @@ Page {
                 y: checkBox.height / 2 - height / 2
                 color: "transparent"
                 Image {
-                    source: checkBox.checked ? "icon:/primary/checkbox_checked.svg" :
-                                               "icon:/primary/checkbox_unchecked.svg"
-                    cache: false
+                    source: (checkBox.checked ? "icon:/primary/checkbox_checked.svg" :
+                                                "icon:/primary/checkbox_unchecked.svg")
+                            + "?" + Theme.generation
                 }
             }
         }
@@ -53,7 +51,7 @@ Page {
 
                     verticalAlignment: Text.AlignVCenter
                     leftPadding: radioButton.indicator.width + radioButton.spacing
-                    color: systemPalette.text
+                    color: Theme.secondaryTextColor
                 }
 
                 indicator: Rectangle {
@@ -63,10 +61,10 @@ Page {
                     y: radioButton.height / 2 - height / 2
                     color: "transparent"
                     Image {
-                        source: radioButton.checked ?
+                        source: (radioButton.checked ?
                                     "icon:/primary/radiobutton_checked.svg" :
-                                    "icon:/primary/radiobutton_unchecked.svg"
-                        cache: false
+                                    "icon:/primary/radiobutton_unchecked.svg")
+                                + "?" + Theme.generation
                     }
                 }
             }
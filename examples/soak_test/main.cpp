@@ -0,0 +1,320 @@
+//============================================================================
+/// \file   main.cpp
+/// \author Uwe Kindler
+/// \date   19.10.2026
+/// \brief  Soak test for long running applications that switch themes
+///
+/// The test runs many style, theme and theme variable switches on the
+/// offscreen platform and creates and destroys theme aware icons in each
+/// cycle. It tracks the resident set size, the live icon engines, the icon
+/// search paths, the font families and the cycle latency. The test fails
+/// with exit code 1, if one of them grows after the warmup phase.
+///
+/// Usage: soak_test [--cycles N] [--warmup N] [--style NAME]
+///        [--max-rss-growth KiB] [--max-latency-drift PERCENT]
+//============================================================================
+#include <QtAdvancedStylesheet.h>
+
+#include <QApplication>
+#include <QColor>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFontDatabase>
+#include <QIcon>
+#include <QLabel>
+#include <QPushButton>
+#include <QTextStream>
+#include <QVBoxLayout>
+#include <QWidget>
+
+#include <algorithm>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+using namespace acss;
+
+#define _STR(x) #x
+#define STRINGIFY(x)  _STR(x)
+
+
+/**
+ * Returns the resident set size of the process in KiB or -1, if it is
+ * not available on this platform
+ */
+static qint64 residentSetSizeKiB()
+{
+#ifdef Q_OS_LINUX
+	QFile Statm("/proc/self/statm");
+	if (!Statm.open(QIODevice::ReadOnly))
+	{
+		return -1;
+	}
+	const auto Fields = Statm.readAll().split(' ');
+	if (Fields.size() < 2)
+	{
+		return -1;
+	}
+	return Fields[1].toLongLong() * sysconf(_SC_PAGESIZE) / 1024;
+#else
+	return -1;
+#endif
+}
+
+
+/**
+ * Returns the number of font families of the font database
+ */
+static int fontFamilyCount()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+	return QFontDatabase::families().size();
+#else
+	return QFontDatabase().families().size();
+#endif
+}
+
+
+/**
+ * Returns the median of the given samples in milliseconds
+ */
+static double medianMs(QVector<qint64> Samples)
+{
+	if (Samples.isEmpty())
+	{
+		return 0;
+	}
+	std::sort(Samples.begin(), Samples.end());
+	return Samples[Samples.size() / 2] / 1e6;
+}
+
+
+/**
+ * The values that are checked for growth
+ */
+struct Sample
+{
+	int Cycle = 0;
+	qint64 RssKiB = -1;
+	int IconEngines = 0;
+	int SearchPaths = 0;
+	int FontFamilies = 0;
+	qint64 LibraryKiB = 0;
+	double MedianMs = 0;
+};
+
+
+/**
+ * Takes a sample of the current process state
+ */
+static Sample takeSample(int Cycle, const QtAdvancedStylesheet& AdvancedStylesheet,
+	const QVector<qint64>& Latencies)
+{
+	Sample Result;
+	const auto Usage = AdvancedStylesheet.memoryUsage();
+	Result.Cycle = Cycle;
+	Result.RssKiB = residentSetSizeKiB();
+	Result.IconEngines = Usage.IconEngineCount;
+	Result.SearchPaths = QDir::searchPaths(AdvancedStylesheet.iconUrlPrefix()).size();
+	Result.FontFamilies = fontFamilyCount();
+	Result.LibraryKiB = Usage.totalBytes() / 1024;
+	Result.MedianMs = medianMs(Latencies);
+	return Result;
+}
+
+
+int main(int argc, char *argv[])
+{
+	// The soak test runs headless on CI machines without GPU
+	if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+	{
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+	}
+	QApplication a(argc, argv);
+
+	int Cycles = 20000;
+	int Warmup = -1;
+	QString Style = "qt_material";
+	qint64 MaxRssGrowthKiB = 20 * 1024;
+	double MaxLatencyDrift = 50;
+	const auto Args = a.arguments();
+	for (int i = 1; i < Args.size() - 1; ++i)
+	{
+		if (Args[i] == "--cycles") Cycles = Args[++i].toInt();
+		else if (Args[i] == "--warmup") Warmup = Args[++i].toInt();
+		else if (Args[i] == "--style") Style = Args[++i];
+		else if (Args[i] == "--max-rss-growth") MaxRssGrowthKiB = Args[++i].toLongLong();
+		else if (Args[i] == "--max-latency-drift") MaxLatencyDrift = Args[++i].toDouble();
+	}
+	if (Warmup < 0)
+	{
+		Warmup = qMin(1000, Cycles / 10);
+	}
+	Warmup = qMax(1, Warmup);
+	const int SampleInterval = qMax(1, Cycles / 20);
+
+	QtAdvancedStylesheet AdvancedStylesheet;
+	AdvancedStylesheet.setStylesDirPath(STRINGIFY(STYLES_DIR));
+	AdvancedStylesheet.setOutputDirPath(a.applicationDirPath() + "/output");
+
+	// Fonts are only added, if there are widgets
+	QWidget Window;
+	auto Layout = new QVBoxLayout(&Window);
+	auto Label = new QLabel("Soak test", &Window);
+	Layout->addWidget(Label);
+	auto Button = new QPushButton("Button", &Window);
+	Layout->addWidget(Button);
+	Window.show();
+
+	if (!AdvancedStylesheet.setCurrentStyle(Style))
+	{
+		qCritical() << "Loading style" << Style << "failed:" << AdvancedStylesheet.errorString();
+		return 1;
+	}
+	AdvancedStylesheet.setDefaultTheme();
+	AdvancedStylesheet.updateStylesheet();
+	a.setStyleSheet(AdvancedStylesheet.styleSheet());
+
+	QStringList IconFiles;
+	QDir ImagesDir(STRINGIFY(IMAGES_DIR));
+	for (const auto& File : ImagesDir.entryInfoList({"*.svg"}, QDir::Files))
+	{
+		IconFiles.append(File.absoluteFilePath());
+	}
+
+	QTextStream Out(stdout);
+	Out << "Cycles: " << Cycles << " Warmup: " << Warmup << " Icons per cycle: "
+		<< IconFiles.size() << "\n";
+	Out << QString("%1 %2 %3 %4 %5 %6 %7\n").arg("cycle", 8).arg("rss [KiB]", 10)
+		.arg("engines", 8).arg("paths", 6).arg("fonts", 6).arg("lib [KiB]", 10)
+		.arg("p50 [ms]", 9);
+	Out.flush();
+
+	QVector<qint64> Latencies;
+	QVector<Sample> Samples;
+	Sample Baseline;
+	QElapsedTimer Timer;
+	int ThemeSwitches = 0;
+	for (int Cycle = 1; Cycle <= Cycles; ++Cycle)
+	{
+		Timer.start();
+		if (Cycle % 1000 == 0)
+		{
+			const auto& Styles = AdvancedStylesheet.styles();
+			AdvancedStylesheet.setCurrentStyle(Styles.isEmpty() ? Style
+				: Styles[(Cycle / 1000) % Styles.size()]);
+			AdvancedStylesheet.setDefaultTheme();
+		}
+		else if (Cycle % 2)
+		{
+			// Themes are only switched in odd cycles - a separate counter
+			// ensures that all themes are used
+			const auto& Themes = AdvancedStylesheet.themes();
+			AdvancedStylesheet.setCurrentTheme(Themes[ThemeSwitches++ % Themes.size()]);
+		}
+		else
+		{
+			AdvancedStylesheet.setThemeVariableValue("primaryColor",
+				QColor::fromHsv(Cycle % 360, 200, 200).name());
+		}
+		AdvancedStylesheet.updateStylesheet();
+		a.setStyleSheet(AdvancedStylesheet.styleSheet());
+
+		// Icons are created and destroyed in each cycle. One icon stays
+		// alive until the next cycle replaces it.
+		{
+			QList<QIcon> Icons;
+			for (const auto& IconFile : IconFiles)
+			{
+				Icons.append(AdvancedStylesheet.loadThemeAwareSvgIcon(IconFile));
+				Icons.last().pixmap(32);
+			}
+			if (!Icons.isEmpty())
+			{
+				Button->setIcon(Icons[Cycle % Icons.size()]);
+			}
+		}
+		a.processEvents();
+		Latencies.append(Timer.nsecsElapsed());
+
+		if (Cycle == Warmup)
+		{
+			Latencies.clear();
+			Baseline = takeSample(Cycle, AdvancedStylesheet, Latencies);
+		}
+		if (Cycle % SampleInterval && Cycle != Cycles)
+		{
+			continue;
+		}
+
+		auto Current = takeSample(Cycle, AdvancedStylesheet, Latencies);
+		Latencies.clear();
+		Samples.append(Current);
+		Out << QString("%1 %2 %3 %4 %5 %6 %7\n").arg(Current.Cycle, 8)
+			.arg(Current.RssKiB, 10).arg(Current.IconEngines, 8)
+			.arg(Current.SearchPaths, 6).arg(Current.FontFamilies, 6)
+			.arg(Current.LibraryKiB, 10).arg(Current.MedianMs, 9, 'f', 2);
+		Out.flush();
+	}
+
+	// The latency of the first sample after the warmup is compared with
+	// the latency of the last sample
+	QStringList Failures;
+	QVector<Sample> MeasuredSamples;
+	for (const auto& Entry : Samples)
+	{
+		if (Entry.Cycle > Warmup)
+		{
+			MeasuredSamples.append(Entry);
+		}
+	}
+	if (MeasuredSamples.isEmpty())
+	{
+		Out << "\nNo samples after the warmup - increase --cycles\n";
+		return 1;
+	}
+
+	const auto& Last = MeasuredSamples.last();
+	const auto& First = MeasuredSamples.first();
+	if (Baseline.RssKiB >= 0 && Last.RssKiB - Baseline.RssKiB > MaxRssGrowthKiB)
+	{
+		Failures.append(QString("RSS grew by %1 KiB").arg(Last.RssKiB - Baseline.RssKiB));
+	}
+	if (Last.IconEngines > Baseline.IconEngines)
+	{
+		Failures.append(QString("Icon engines grew from %1 to %2")
+			.arg(Baseline.IconEngines).arg(Last.IconEngines));
+	}
+	if (Last.SearchPaths > Baseline.SearchPaths)
+	{
+		Failures.append(QString("Icon search paths grew from %1 to %2")
+			.arg(Baseline.SearchPaths).arg(Last.SearchPaths));
+	}
+	if (Last.FontFamilies > Baseline.FontFamilies)
+	{
+		Failures.append(QString("Font families grew from %1 to %2")
+			.arg(Baseline.FontFamilies).arg(Last.FontFamilies));
+	}
+	if (MeasuredSamples.size() > 1
+	 && Last.MedianMs > First.MedianMs * (1 + MaxLatencyDrift / 100))
+	{
+		Failures.append(QString("Cycle latency drifted from %1 ms to %2 ms")
+			.arg(First.MedianMs, 0, 'f', 2).arg(Last.MedianMs, 0, 'f', 2));
+	}
+
+	if (Failures.isEmpty())
+	{
+		Out << "\nPASSED\n";
+		return 0;
+	}
+
+	Out << "\nFAILED\n";
+	for (const auto& Failure : Failures)
+	{
+		Out << "  " << Failure << "\n";
+	}
+	return 1;
+}
@@ -0,0 +1,294 @@
+//============================================================================
+/// \file   main.cpp
+/// \author Uwe Kindler
+/// \date   19.10.2026
+/// \brief  Measures the user visible cost of theme switches
+///
+/// The benchmark builds a large widget gallery on the offscreen platform
+/// and cycles through all themes of a style. For each switch it measures
+/// the time spent in updateStylesheet(), qApp->setStyleSheet(), the
+/// repolishing of the widgets and the first full repaint and prints
+/// the percentiles of all phases.
+///
+/// With --profile-polish the benchmark profiles the polish, style change
+/// and paint events of all widgets during the theme switches and prints
+/// the most expensive widget classes with their stylesheet sections.
+///
+/// With --deferred the benchmark enables deferred work. The deferred work
+/// is flushed after each measured switch.
+///
+/// Usage: theme_switch_benchmark [--pages N] [--cycles N] [--style NAME]
+///        [--profile-polish] [--deferred]
+//============================================================================
+#include <QtAdvancedStylesheet.h>
+#include <StylePolishProfiler.h>
+
+#include <QApplication>
+#include <QCheckBox>
+#include <QComboBox>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QGridLayout>
+#include <QVBoxLayout>
+#include <QIcon>
+#include <QGroupBox>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QMainWindow>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QRadioButton>
+#include <QSlider>
+#include <QSpinBox>
+#include <QTabWidget>
+#include <QTableWidget>
+#include <QTextStream>
+#include <QToolBar>
+#include <QToolButton>
+#include <QTreeWidget>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace acss;
+
+#define _STR(x) #x
+#define STRINGIFY(x)  _STR(x)
+
+
+/**
+ * Creates one gallery page with a representative mix of styled widgets
+ */
+static QWidget* createGalleryPage(const QList<QIcon>& Icons)
+{
+	auto Page = new QWidget();
+	auto Layout = new QGridLayout(Page);
+	for (int i = 0; i < 8; ++i)
+	{
+		const auto& Icon = Icons.at(i % Icons.size());
+		auto Group = new QGroupBox(QString("Group %1").arg(i), Page);
+		Group->setCheckable(i % 2);
+		auto GroupLayout = new QVBoxLayout(Group);
+		auto Button = new QPushButton(Icon, "Push Button", Group);
+		GroupLayout->addWidget(Button);
+		auto ToolButton = new QToolButton(Group);
+		ToolButton->setIcon(Icon);
+		GroupLayout->addWidget(ToolButton);
+		auto CheckBox = new QCheckBox("Check Box", Group);
+		CheckBox->setTristate(true);
+		CheckBox->setCheckState(static_cast<Qt::CheckState>(i % 3));
+		GroupLayout->addWidget(CheckBox);
+		auto RadioButton = new QRadioButton("Radio Button", Group);
+		RadioButton->setChecked(i % 2);
+		GroupLayout->addWidget(RadioButton);
+		auto ComboBox = new QComboBox(Group);
+		ComboBox->addItems({"Item 1", "Item 2", "Item 3"});
+		GroupLayout->addWidget(ComboBox);
+		GroupLayout->addWidget(new QSpinBox(Group));
+		GroupLayout->addWidget(new QLineEdit("Line Edit", Group));
+		auto Slider = new QSlider(Qt::Horizontal, Group);
+		Slider->setValue(i * 10);
+		GroupLayout->addWidget(Slider);
+		auto ProgressBar = new QProgressBar(Group);
+		ProgressBar->setValue(i * 10);
+		GroupLayout->addWidget(ProgressBar);
+		Group->setEnabled(i != 7);
+		Layout->addWidget(Group, i / 4, i % 4);
+	}
+
+	auto ListWidget = new QListWidget(Page);
+	auto TreeWidget = new QTreeWidget(Page);
+	TreeWidget->setHeaderLabels({"Name", "Value"});
+	auto TableWidget = new QTableWidget(50, 4, Page);
+	for (int i = 0; i < 50; ++i)
+	{
+		const auto& Icon = Icons.at(i % Icons.size());
+		auto ListItem = new QListWidgetItem(Icon, QString("List Item %1").arg(i), ListWidget);
+		ListItem->setFlags(ListItem->flags() | Qt::ItemIsUserCheckable);
+		ListItem->setCheckState((i % 2) ? Qt::Checked : Qt::Unchecked);
+		auto TreeItem = new QTreeWidgetItem(TreeWidget, {QString("Tree Item %1").arg(i), "Value"});
+		TreeItem->setIcon(0, Icon);
+		new QTreeWidgetItem(TreeItem, {"Child", "Value"});
+		for (int Column = 0; Column < 4; ++Column)
+		{
+			auto TableItem = new QTableWidgetItem(QString("Cell %1").arg(Column));
+			TableItem->setFlags(TableItem->flags() | Qt::ItemIsUserCheckable);
+			TableItem->setCheckState(Qt::Checked);
+			TableWidget->setItem(i, Column, TableItem);
+		}
+	}
+	Layout->addWidget(ListWidget, 2, 0);
+	Layout->addWidget(TreeWidget, 2, 1);
+	Layout->addWidget(TableWidget, 2, 2, 1, 2);
+	return Page;
+}
+
+
+/**
+ * Application that lets the polish profiler measure the event delivery
+ */
+class CBenchmarkApplication : public QApplication
+{
+public:
+	using QApplication::QApplication;
+	acss::CStylePolishProfiler* Profiler = nullptr;
+
+	bool notify(QObject* Receiver, QEvent* Event) override
+	{
+		if (!Profiler)
+		{
+			return QApplication::notify(Receiver, Event);
+		}
+		return Profiler->notify(Receiver, Event,
+			[&]() {return QApplication::notify(Receiver, Event);});
+	}
+};
+
+
+/**
+ * Returns the given percentile of the sorted samples in milliseconds
+ */
+static double percentile(const QVector<qint64>& SortedSamples, double Percentile)
+{
+	if (SortedSamples.isEmpty())
+	{
+		return 0;
+	}
+	int Index = static_cast<int>(std::ceil(Percentile / 100.0 * SortedSamples.size())) - 1;
+	Index = qBound(0, Index, SortedSamples.size() - 1);
+	return SortedSamples.at(Index) / 1000000.0;
+}
+
+
+int main(int argc, char *argv[])
+{
+	// The benchmark runs headless on CI machines without GPU
+	if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+	{
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+	}
+	CBenchmarkApplication a(argc, argv);
+
+	int Pages = 20;
+	int Cycles = 3;
+	QString Style = "qt_material";
+	const auto Args = a.arguments();
+	for (int i = 1; i < Args.size() - 1; ++i)
+	{
+		if (Args[i] == "--pages") Pages = Args[++i].toInt();
+		else if (Args[i] == "--cycles") Cycles = Args[++i].toInt();
+		else if (Args[i] == "--style") Style = Args[++i];
+	}
+	const bool ProfilePolish = Args.contains("--profile-polish");
+	const bool Deferred = Args.contains("--deferred");
+
+	QtAdvancedStylesheet AdvancedStylesheet;
+	AdvancedStylesheet.setStylesDirPath(STRINGIFY(STYLES_DIR));
+	AdvancedStylesheet.setOutputDirPath(a.applicationDirPath() + "/output");
+	AdvancedStylesheet.setDeferredWorkEnabled(Deferred);
+	if (!AdvancedStylesheet.setCurrentStyle(Style))
+	{
+		qCritical() << "Loading style" << Style << "failed:" << AdvancedStylesheet.errorString();
+		return 1;
+	}
+	AdvancedStylesheet.setDefaultTheme();
+	AdvancedStylesheet.updateStylesheet();
+	a.setStyleSheet(AdvancedStylesheet.styleSheet());
+
+	QList<QIcon> Icons;
+	QDir ImagesDir(STRINGIFY(IMAGES_DIR));
+	for (const auto& File : ImagesDir.entryInfoList({"*.svg"}, QDir::Files))
+	{
+		Icons.append(AdvancedStylesheet.loadThemeAwareSvgIcon(File.absoluteFilePath()));
+	}
+	if (Icons.isEmpty())
+	{
+		Icons.append(QIcon());
+	}
+
+	QMainWindow Window;
+	auto ToolBar = Window.addToolBar("Tools");
+	for (const auto& Icon : Icons)
+	{
+		ToolBar->addAction(Icon, "Action");
+	}
+	auto TabWidget = new QTabWidget(&Window);
+	for (int i = 0; i < Pages; ++i)
+	{
+		TabWidget->addTab(createGalleryPage(Icons), QString("Page %1").arg(i));
+	}
+	Window.setCentralWidget(TabWidget);
+	Window.resize(1600, 1000);
+	Window.show();
+	a.processEvents();
+
+	QTextStream Out(stdout);
+	Out << "Widgets: " << a.allWidgets().size() << " Themes: "
+		<< AdvancedStylesheet.themes().size() << " Cycles: " << Cycles << "\n";
+
+	enum ePhase {UpdateStylesheet, SetStyleSheet, Repolish, Repaint, Total, PhaseCount};
+	const char* PhaseNames[] = {"updateStylesheet()", "qApp->setStyleSheet()",
+		"repolish", "first full repaint", "total"};
+	QVector<qint64> Samples[PhaseCount];
+	QElapsedTimer Timer;
+	acss::CStylePolishProfiler Profiler;
+	if (ProfilePolish)
+	{
+		Profiler.setStylesheet(AdvancedStylesheet.styleSheet());
+		a.Profiler = &Profiler;
+		Profiler.start();
+	}
+	for (int Cycle = 0; Cycle < Cycles; ++Cycle)
+	{
+		for (const auto& Theme : AdvancedStylesheet.themes())
+		{
+			qint64 Times[PhaseCount];
+			Timer.start();
+			AdvancedStylesheet.setCurrentTheme(Theme);
+			AdvancedStylesheet.updateStylesheet();
+			Times[UpdateStylesheet] = Timer.nsecsElapsed();
+
+			Timer.start();
+			a.setStyleSheet(AdvancedStylesheet.styleSheet());
+			Times[SetStyleSheet] = Timer.nsecsElapsed();
+
+			// Processes the pending style change, polish and layout events
+			Timer.start();
+			a.processEvents();
+			Times[Repolish] = Timer.nsecsElapsed();
+
+			Timer.start();
+			Window.repaint();
+			Times[Repaint] = Timer.nsecsElapsed();
+
+			Times[Total] = Times[UpdateStylesheet] + Times[SetStyleSheet]
+				+ Times[Repolish] + Times[Repaint];
+			for (int Phase = 0; Phase < PhaseCount; ++Phase)
+			{
+				Samples[Phase].append(Times[Phase]);
+			}
+			AdvancedStylesheet.flushDeferredWork();
+		}
+	}
+
+	Out << QString("%1 %2 %3 %4 %5\n").arg("phase [ms]", -24).arg("p50", 10)
+		.arg("p90", 10).arg("p99", 10).arg("max", 10);
+	for (int Phase = 0; Phase < PhaseCount; ++Phase)
+	{
+		auto& PhaseSamples = Samples[Phase];
+		std::sort(PhaseSamples.begin(), PhaseSamples.end());
+		Out << QString("%1 %2 %3 %4 %5\n").arg(PhaseNames[Phase], -24)
+			.arg(percentile(PhaseSamples, 50), 10, 'f', 2)
+			.arg(percentile(PhaseSamples, 90), 10, 'f', 2)
+			.arg(percentile(PhaseSamples, 99), 10, 'f', 2)
+			.arg(percentile(PhaseSamples, 100), 10, 'f', 2);
+	}
+
+	if (ProfilePolish)
+	{
+		Profiler.stop();
+		Profiler.measureRepolish(&Window);
+		Out << "\n" << Profiler.report();
+	}
+	return 0;
+}
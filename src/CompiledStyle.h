@@ -0,0 +1,162 @@
+#ifndef CompiledStyleH
+#define CompiledStyleH
+/*******************************************************************************
+** Qt Advanced Stylesheets
+** Copyright (C) 2022 Uwe Kindler
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+
+//============================================================================
+/// \file   CompiledStyle.h
+/// \author Uwe Kindler
+/// \date   19.10.2026
+/// \brief  Declaration of the data tables of a compiled style
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+
+
+namespace acss
+{
+/**
+ * A segment of the CSS template of a compiled style.
+ * A segment is either literal text or a theme variable with an optional
+ * opacity ("{{primaryColor|opacity(0.5)}}").
+ */
+struct CompiledTemplateSegment
+{
+	const char* Text;///< literal UTF-8 text or the variable name
+	int Size;///< size of Text in bytes
+	bool IsVariable;
+	float Opacity;///< opacity of the variable or a value < 0 for no opacity
+};
+
+/**
+ * A name value pair of a style variable or of a theme color
+ */
+struct CompiledVariable
+{
+	const char* Name;
+	const char* Value;
+};
+
+/**
+ * A theme of a compiled style with its color variables
+ */
+struct CompiledTheme
+{
+	const char* Name;
+	bool IsDark;
+	const CompiledVariable* Colors;
+	int ColorCount;
+};
+
+/**
+ * Assigns a theme color variable to a palette color group and role.
+ * Group and Role are QPalette::ColorGroup and QPalette::ColorRole values.
+ */
+struct CompiledPaletteEntry
+{
+	int Group;
+	int Role;
+	const char* ColorVariable;
+};
+
+/**
+ * Replaces a template color in SVG data with a color value or a theme
+ * variable
+ */
+struct CompiledColorReplace
+{
+	const char* TemplateColor;
+	const char* Color;
+};
+
+/**
+ * A named color replace list - a resource variant like "primary" or
+ * the icon colors of the style
+ */
+struct CompiledColorReplaceList
+{
+	const char* Name;
+	const CompiledColorReplace* Entries;
+	int EntryCount;
+};
+
+/**
+ * SVG resource template of a compiled style
+ */
+struct CompiledResource
+{
+	const char* FileName;
+	const char* Data;
+	int Size;
+};
+
+/**
+ * Font file of a compiled style
+ */
+struct CompiledFont
+{
+	const char* FileName;
+	const unsigned char* Data;
+	int Size;
+};
+
+/**
+ * All data of a style that has been compiled into C++ sources by the
+ * acss_stylec tool. Pass it to QtAdvancedStylesheet::setCurrentStyle()
+ * to use the style without any style files on disk.
+ */
+struct CompiledStyle
+{
+	const char* Style;///< name of the style folder - e.g. "qt_material"
+	const char* Name;///< name of the style from the style json file
+	const char* DefaultTheme;
+	const char* CssTemplateName;///< file name of the CSS template
+	const char* PaletteBaseColor;
+	const char* IconSvg;///< SVG data of the style icon
+	int IconSvgSize;
+	const CompiledVariable* Variables;
+	int VariableCount;
+	const CompiledTheme* Themes;
+	int ThemeCount;
+	const CompiledPaletteEntry* PaletteEntries;
+	int PaletteEntryCount;
+	const CompiledTemplateSegment* TemplateSegments;
+	int TemplateSegmentCount;
+	const CompiledColorReplaceList* ResourceVariants;
+	int ResourceVariantCount;
+	const CompiledColorReplaceList* IconColors;///< "icon_colors" lists per icon mode
+	int IconColorsCount;
+	const CompiledResource* Resources;
+	int ResourceCount;
+	const CompiledFont* Fonts;
+	int FontCount;
+};
+} // namespace acss
+
+/**
+ * Declares a style that has been compiled by acss_stylec with the
+ * given identifier
+ */
+#define ACSS_DECLARE_COMPILED_STYLE(Identifier) \
+	extern const acss::CompiledStyle Identifier;
+
+//---------------------------------------------------------------------------
+#endif // CompiledStyleH
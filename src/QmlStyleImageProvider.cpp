@@ -0,0 +1,131 @@
+/*******************************************************************************
+** Qt Advanced Stylesheets
+** Copyright (C) 2022 Uwe Kindler
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+
+//============================================================================
+/// \file   QmlStyleImageProvider.cpp
+/// \author Uwe Kindler
+/// \date   19.10.2026
+/// \brief  Implementation of the CQmlStyleImageProvider class.
+//============================================================================
+
+//============================================================================
+//                                  INCLUDES
+//============================================================================
+#include "QmlStyleImageProvider.h"
+
+#include <QImage>
+#include <QPainter>
+#include <QRunnable>
+#include <QSvgRenderer>
+
+#include "QtAdvancedStylesheet.h"
+
+namespace acss
+{
+/**
+ * Image response that loads and rasterizes the SVG data in a worker thread
+ */
+class CSvgImageResponse : public QQuickImageResponse, public QRunnable
+{
+public:
+    CSvgImageResponse(QtAdvancedStylesheet* AdvancedStylesheet, const QString& Id,
+        const QSize& RequestedSize)
+        : m_AdvancedStylesheet(AdvancedStylesheet),
+          m_Id(Id),
+          m_RequestedSize(RequestedSize)
+    {
+        setAutoDelete(false);
+    }
+
+    QQuickTextureFactory* textureFactory() const override
+    {
+        return QQuickTextureFactory::textureFactoryForImage(m_Image);
+    }
+
+    QString errorString() const override
+    {
+        return m_ErrorString;
+    }
+
+    void run() override
+    {
+        // A query like "?42" is only used to request a new image for a new
+        // theme generation
+        const auto Id = m_Id.section('?', 0, 0);
+        const auto Variant = Id.section('/', 0, 0);
+        const auto SvgData = m_AdvancedStylesheet->isResourceVariant(Variant)
+            ? m_AdvancedStylesheet->resourceSvgData(Id)
+            : m_AdvancedStylesheet->themeAwareSvgData(Id);
+        QSvgRenderer Renderer(SvgData);
+        if (SvgData.isEmpty() || !Renderer.isValid())
+        {
+            m_ErrorString = "Failed to load SVG image " + m_Id;
+            emit finished();
+            return;
+        }
+
+        // If only one dimension is requested, we keep the aspect ratio
+        QSize Size = Renderer.defaultSize();
+        if (m_RequestedSize.width() > 0 && m_RequestedSize.height() > 0)
+        {
+            Size = m_RequestedSize;
+        }
+        else if (m_RequestedSize.width() > 0 && !Size.isEmpty())
+        {
+            Size = QSize(m_RequestedSize.width(),
+                m_RequestedSize.width() * Size.height() / Size.width());
+        }
+        else if (m_RequestedSize.height() > 0 && !Size.isEmpty())
+        {
+            Size = QSize(m_RequestedSize.height() * Size.width() / Size.height(),
+                m_RequestedSize.height());
+        }
+
+        m_Image = QImage(Size, QImage::Format_ARGB32_Premultiplied);
+        m_Image.fill(Qt::transparent);
+        QPainter Painter(&m_Image);
+        Renderer.render(&Painter);
+        Painter.end();
+        emit finished();
+    }
+
+private:
+    QtAdvancedStylesheet* m_AdvancedStylesheet;
+    QString m_Id;
+    QSize m_RequestedSize;
+    QImage m_Image;
+    QString m_ErrorString;
+};
+
+
+//=============================================================================
+CQmlStyleImageProvider::CQmlStyleImageProvider(QtAdvancedStylesheet* AdvancedStylesheet)
+    : m_AdvancedStylesheet{AdvancedStylesheet}
+{}
+
+
+//=============================================================================
+QQuickImageResponse* CQmlStyleImageProvider::requestImageResponse(const QString& id,
+    const QSize& requestedSize)
+{
+    auto Response = new CSvgImageResponse(m_AdvancedStylesheet, id, requestedSize);
+    m_ThreadPool.start(Response);
+    return Response;
+}
+}  // namespace acss
@@ -0,0 +1,84 @@
+#ifndef ACSS_CQMLSTYLEIMAGEPROVIDER_H
+#define ACSS_CQMLSTYLEIMAGEPROVIDER_H
+/*******************************************************************************
+** Qt Advanced Stylesheets
+** Copyright (C) 2022 Uwe Kindler
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+
+//============================================================================
+/// \file   QmlStyleImageProvider.h
+/// \author Uwe Kindler
+/// \date   19.10.2026
+/// \brief  Declaration of the CQmlStyleImageProvider class.
+//============================================================================
+
+
+//============================================================================
+//                                  INCLUDES
+//============================================================================
+#include <QQuickAsyncImageProvider>
+#include <QThreadPool>
+
+#include "acss_globals.h"
+
+namespace acss
+{
+class QtAdvancedStylesheet;
+
+/**
+ * @brief The CQmlStyleImageProvider class provides an asynchronous image
+ * provider that serves recolored style resources and theme aware SVG files
+ * straight from the in-process recolor cache of a @c QtAdvancedStylesheet.
+ *
+ * The SVG images are rasterized on worker threads at the requested size.
+ * No generated output files are required.
+ * @code
+ * auto Interceptor = new CQmlStyleUrlInterceptor(AdvancedStylesheet);
+ * Interceptor->setImageProviderId("acss");
+ * Engine->addImageProvider("acss", new CQmlStyleImageProvider(AdvancedStylesheet));
+ * Engine->addUrlInterceptor(Interceptor);
+ * @endcode
+ * The provider supports two kinds of image ids:
+ * - style resources - the first path segment is a resource variant like in
+ *   @c "image://acss/primary/checkbox_checked.svg"
+ * - any other id is treated as the file name of a theme aware SVG file
+ *   that gets the icon colors of the style like in
+ *   @c "image://acss/:/images/edit.svg"
+ */
+class ACSS_EXPORT CQmlStyleImageProvider : public QQuickAsyncImageProvider
+{
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param AdvancedStylesheet The stylesheet that provides the SVG data.
+     * The stylesheet needs to outlive the QML engine that uses this provider.
+     */
+    CQmlStyleImageProvider(QtAdvancedStylesheet* AdvancedStylesheet);
+
+    // implements QQuickAsyncImageProvider ------------------------------------
+    QQuickImageResponse* requestImageResponse(const QString& id,
+        const QSize& requestedSize) override;
+
+private:
+    QtAdvancedStylesheet* m_AdvancedStylesheet;
+    QThreadPool m_ThreadPool;
+};
+
+}  // namespace acss
+
+#endif  // ACSS_CQMLSTYLEIMAGEPROVIDER_H
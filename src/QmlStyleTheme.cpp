@@ -0,0 +1,115 @@
+/*******************************************************************************
+** Qt Advanced Stylesheets
+** Copyright (C) 2022 Uwe Kindler
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+
+//============================================================================
+/// \file   QmlStyleTheme.cpp
+/// \author Uwe Kindler
+/// \date   19.10.2026
+/// \brief  Implementation of the CQmlStyleTheme class.
+//============================================================================
+
+//============================================================================
+//                                  INCLUDES
+//============================================================================
+#include "QmlStyleTheme.h"
+
+#include <QColor>
+
+#include "QtAdvancedStylesheet.h"
+
+namespace acss
+{
+//=============================================================================
+CQmlStyleTheme::CQmlStyleTheme(QtAdvancedStylesheet* AdvancedStylesheet, QObject* Parent)
+    : QQmlPropertyMap(this, Parent),
+      m_AdvancedStylesheet{AdvancedStylesheet}
+{
+    connect(m_AdvancedStylesheet, &QtAdvancedStylesheet::stylesheetChanged,
+        this, &CQmlStyleTheme::update);
+    connect(m_AdvancedStylesheet, &QtAdvancedStylesheet::changesCommitted,
+        this, &CQmlStyleTheme::update);
+    update();
+}
+
+//=============================================================================
+int CQmlStyleTheme::generation() const
+{
+    return m_Generation;
+}
+
+//=============================================================================
+bool CQmlStyleTheme::isDark() const
+{
+    return m_Dark;
+}
+
+//=============================================================================
+QString CQmlStyleTheme::theme() const
+{
+    return m_Theme;
+}
+
+//=============================================================================
+void CQmlStyleTheme::update()
+{
+    const auto& Variables = m_AdvancedStylesheet->themeVariables();
+    const auto& Colors = m_AdvancedStylesheet->themeColorVariables();
+
+    // Variables that do not exist in the current style anymore get an
+    // invalid value. QQmlPropertyMap keeps the keys, so we only touch keys
+    // that still have a value.
+    for (const auto& Key : keys())
+    {
+        if (!Variables.contains(Key) && value(Key).isValid())
+        {
+            insert(Key, QVariant());
+        }
+    }
+
+    // We only touch changed values to re-evaluate only the bindings that
+    // depend on them
+    for (auto itc = Variables.constBegin(); itc != Variables.constEnd(); ++itc)
+    {
+        QVariant Value = Colors.contains(itc.key())
+            ? QVariant(QColor(itc.value())) : QVariant(itc.value());
+        if (!contains(itc.key()) || value(itc.key()) != Value)
+        {
+            insert(itc.key(), Value);
+        }
+    }
+
+    if (m_Dark != m_AdvancedStylesheet->isCurrentThemeDark())
+    {
+        m_Dark = m_AdvancedStylesheet->isCurrentThemeDark();
+        emit darkChanged();
+    }
+
+    if (m_Theme != m_AdvancedStylesheet->currentTheme())
+    {
+        m_Theme = m_AdvancedStylesheet->currentTheme();
+        emit themeChanged();
+    }
+
+    if (m_Generation != m_AdvancedStylesheet->themeGeneration())
+    {
+        m_Generation = m_AdvancedStylesheet->themeGeneration();
+        emit generationChanged();
+    }
+}
+}  // namespace acss
@@ -0,0 +1,117 @@
+#ifndef ACSS_CQMLSTYLETHEME_H
+#define ACSS_CQMLSTYLETHEME_H
+/*******************************************************************************
+** Qt Advanced Stylesheets
+** Copyright (C) 2022 Uwe Kindler
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+
+//============================================================================
+/// \file   QmlStyleTheme.h
+/// \author Uwe Kindler
+/// \date   19.10.2026
+/// \brief  Declaration of the CQmlStyleTheme class.
+//============================================================================
+
+
+//============================================================================
+//                                  INCLUDES
+//============================================================================
+#include <QQmlPropertyMap>
+
+#include "acss_globals.h"
+
+namespace acss
+{
+class QtAdvancedStylesheet;
+
+/**
+ * @brief The CQmlStyleTheme class exposes all theme variables of a
+ * @c QtAdvancedStylesheet as notifiable QML properties.
+ *
+ * Color variables are exposed as @c color values and all other variables
+ * as strings. If the stylesheet changes, only the changed properties are
+ * updated, so QML only re-evaluates the bindings that depend on them and
+ * there is no need to reload the QML scene.
+ * @code
+ * auto Theme = new CQmlStyleTheme(AdvancedStylesheet, Widget);
+ * Widget->rootContext()->setContextProperty("Theme", Theme);
+ * @endcode
+ * In QML you can bind to the theme variables and use the generation to
+ * request new icons if the theme changes:
+ * @code
+ * Text {
+ *     color: Theme.secondaryTextColor
+ * }
+ * Image {
+ *     source: "icon:/primary/checkbox_checked.svg?" + Theme.generation
+ * }
+ * @endcode
+ */
+class ACSS_EXPORT CQmlStyleTheme : public QQmlPropertyMap
+{
+    Q_OBJECT
+    Q_PROPERTY(int generation READ generation NOTIFY generationChanged)
+    Q_PROPERTY(bool dark READ isDark NOTIFY darkChanged)
+    Q_PROPERTY(QString theme READ theme NOTIFY themeChanged)
+
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param AdvancedStylesheet The stylesheet that provides the theme variables
+     */
+    CQmlStyleTheme(QtAdvancedStylesheet* AdvancedStylesheet, QObject* Parent = nullptr);
+
+    /**
+     * @brief Returns the theme generation of the last update
+     * @see QtAdvancedStylesheet::themeGeneration()
+     */
+    int generation() const;
+
+    /**
+     * @brief Returns true, if the current theme is a dark theme
+     */
+    bool isDark() const;
+
+    /**
+     * @brief Returns the name of the current theme
+     */
+    QString theme() const;
+
+public slots:
+    /**
+     * @brief Updates all properties from the current theme variables.
+     *
+     * This slot is called automatically if the stylesheet changes
+     */
+    void update();
+
+signals:
+    void generationChanged();
+    void darkChanged();
+    void themeChanged();
+
+private:
+    QtAdvancedStylesheet* m_AdvancedStylesheet;
+    int m_Generation = -1;
+    bool m_Dark = false;
+    QString m_Theme;
+};
+
+}  // namespace acss
+
+#endif  // ACSS_CQMLSTYLETHEME_H
@@ -41,18 +41,67 @@ CQmlStyleUrlInterceptor::CQmlStyleUrlInterceptor(QtAdvancedStylesheet* AdvancedS
     : m_AdvancedStylesheet{AdvancedStylesheet}
 {}
 
+//=============================================================================
+void CQmlStyleUrlInterceptor::setImageProviderId(const QString& ProviderId)
+{
+    m_ImageProviderId = ProviderId;
+}
+
+//=============================================================================
+QString CQmlStyleUrlInterceptor::imageProviderId() const
+{
+    return m_ImageProviderId;
+}
+
 //=============================================================================
 QUrl CQmlStyleUrlInterceptor::intercept(const QUrl& path, DataType type)
 {
-    if (type == UrlString && path.scheme() == "icon")
+    if (type != UrlString)
+    {
+        return path;
+    }
+
+    if (!m_AdvancedStylesheet)
     {
-        if (m_AdvancedStylesheet)
+        if (path.scheme() == "icon")
+        {
+            qWarning() << "AdvancedStylesheet Error: CQmlStyleUrlInterceptor has no "
+                          "valid CStyleManager!";
+        }
+        return path;
+    }
+
+    // QUrl normalizes the scheme to lower case
+    if (path.scheme().compare(m_AdvancedStylesheet->iconUrlPrefix(), Qt::CaseInsensitive) == 0)
+    {
+        // The QML pixmap cache uses the URL as key. The query is kept to
+        // support cache busting URLs like
+        // "icon:/primary/checkbox_checked.svg?" + Theme.generation and URLs
+        // without a query get the current theme generation, so each theme
+        // has its own images in both modes.
+        const auto Query = path.hasQuery() ? path.query()
+            : QString::number(m_AdvancedStylesheet->themeGeneration());
+        if (!m_ImageProviderId.isEmpty())
+        {
+            auto ResourcePath = path.path();
+            if (ResourcePath.startsWith('/'))
+            {
+                ResourcePath.remove(0, 1);
+            }
+            QUrl ImageUrl("image://" + m_ImageProviderId + "/" + ResourcePath);
+            ImageUrl.setQuery(Query);
+            return ImageUrl;
+        }
+        // In lazy resource generation mode, the resource may not have been
+        // generated yet. The query is ignored when the file is loaded.
+        auto Filename = m_AdvancedStylesheet->generateResource(path.path());
+        if (Filename.isEmpty())
         {
-            return QUrl::fromLocalFile(m_AdvancedStylesheet->currentStyleOutputPath()
-                                       + '/' + path.path());
+            Filename = m_AdvancedStylesheet->currentStyleOutputPath() + '/' + path.path();
         }
-        qWarning() << "AdvancedStylesheet Error: CQmlStyleUrlInterceptor has no "
-                      "valid CStyleManager!";
+        auto FileUrl = QUrl::fromLocalFile(Filename);
+        FileUrl.setQuery(Query);
+        return FileUrl;
     }
     return path;
 }
@@ -62,9 +62,14 @@ class QtAdvancedStylesheet;
  *   }
  * }
  * @endcode
- * The @c CQmlStyleUrlInterceptor will intercept all URLs with the "icon:" prefix
+ * The @c CQmlStyleUrlInterceptor will intercept all URLs with the
+ * @c QtAdvancedStylesheet::iconUrlPrefix() prefix ("icon:" by default)
  * and turn them into absolute paths (with the help of the @c QtAdvancedStylesheet
  * instance passed in the constructor) that can be understood by QML.
+ * The resulting URLs contain the theme generation as query, or the query of
+ * the intercepted URL, so the QML pixmap cache does not return images of
+ * the last theme. Bind the URL to @c CQmlStyleTheme::generation to reload
+ * the images when the theme changes.
  */
 class ACSS_EXPORT CQmlStyleUrlInterceptor : public QQmlAbstractUrlInterceptor
 {
@@ -76,11 +81,27 @@ public:
      */
     CQmlStyleUrlInterceptor(QtAdvancedStylesheet* AdvancedStylesheet);
 
+    /**
+     * @brief Routes all intercepted URLs to the image provider with the given
+     * id instead of the generated files in the style output folder.
+     *
+     * Use this together with a @c CQmlStyleImageProvider that has been
+     * added to the QML engine with the same id. Pass an empty string to
+     * resolve the URLs to files again.
+     */
+    void setImageProviderId(const QString& ProviderId);
+
+    /**
+     * @brief Returns the image provider id set via setImageProviderId()
+     */
+    QString imageProviderId() const;
+
     // implements QQmlAbstractUrlInterceptor ---------------------------------
     QUrl intercept(const QUrl& path, DataType type) override;
 
 private:
     QtAdvancedStylesheet* m_AdvancedStylesheet;
+    QString m_ImageProviderId;
 };
 
 }  // namespace acss
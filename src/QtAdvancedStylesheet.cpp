@@ -28,7 +28,13 @@
 //                                   INCLUDES
 //============================================================================
 #include <QtAdvancedStylesheet.h>
+#include <CompiledStyle.h>
+#include <SvgOptimizer.h>
+#include <SharedIconCache.h>
 #include <iostream>
+#include <functional>
+#include <algorithm>
+#include <memory>
 
 #include <QMap>
 #include <QXmlStreamReader>
@@ -47,14 +53,100 @@
 #include <QIconEngine>
 #include <QSvgRenderer>
 #include <QPainter>
+#include <QPicture>
+#include <QBuffer>
+#include <QtConcurrent>
+#include <QFuture>
+#include <QPointer>
 #include <QSet>
+#include <QSaveFile>
+#include <QLockFile>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QHash>
+#include <QStyleOption>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QAtomicInt>
+#include <QDirIterator>
+#include <QTimer>
+#include <QSharedPointer>
+#include <QElapsedTimer>
+#include <QWidget>
 
 
 namespace acss
 {
+using tResourceTemplates = QVector<QPair<QString, QByteArray>>;///< file name and SVG data
+
+/**
+ * A generated SVG resource that needs to be rendered into PNG files
+ */
+struct RasterJob
+{
+	QString SvgFilename;
+	QByteArray Content;
+	QString ErrorString;///< empty on success
+};
 class CSVGIconEngine;
 Q_GLOBAL_STATIC(QSet<CSVGIconEngine*>, IconEngineInstances)
 
+/**
+ * A theme aware icon that has been loaded and recolored by a worker thread
+ * of QtAdvancedStylesheet::preloadThemeAwareSvgIcons()
+ */
+struct PreloadedIcon
+{
+	QString Filename;
+	QByteArray SvgTemplate;
+	QByteArray SvgContent;
+	QByteArray DisabledSvgContent;
+	QByteArray SelectedSvgContent;
+	QVector<QPair<quint64, QImage>> Images;///< prerendered images per pixmap cache key
+	QString ErrorString;///< empty, if the file has been loaded
+};
+
+
+/**
+ * Returns the key of the pixmap cache of the icon engine for the given size
+ * in device pixels, scale and mode
+ */
+static quint64 pixmapCacheKey(const QSize& PixelSize, qreal Scale, QIcon::Mode Mode)
+{
+	// 20 bits per dimension, 16 bits for the scale in percent, so that
+	// device pixel ratios above 2.55 do not wrap around, and 8 bits mode
+	return (quint64(PixelSize.width() & 0xfffff) << 44)
+		| (quint64(PixelSize.height() & 0xfffff) << 24)
+		| (quint64(qRound(Scale * 100) & 0xffff) << 8) | quint64(Mode);
+}
+
+/**
+ * Fonts that have been added to the application font database. The font
+ * database keeps all added fonts, so each font is added only once per
+ * process and not on each style change.
+ */
+Q_GLOBAL_STATIC(QSet<QString>, RegisteredFonts)
+
+/**
+ * The attached shared icon caches. A cache stays attached until the process
+ * exits, so all instances that use the same key share one attachment.
+ */
+using tSharedIconCaches = QHash<QString, QSharedPointer<CSharedIconCache>>;
+Q_GLOBAL_STATIC(tSharedIconCaches, SharedIconCaches)
+
+/**
+ * Number of QtAdvancedStylesheet instances that use an icon URL prefix.
+ * A new instance only uses the default prefix "icon", if no other instance
+ * uses it.
+ */
+Q_GLOBAL_STATIC(QHash<QString, int>, IconUrlPrefixUsers)
+
+/**
+ * Counter for the IDs of the QtAdvancedStylesheet instances. The ID is used
+ * to identify the instance in the thread local snapshot caches.
+ */
+static QAtomicInt StylesheetInstanceCounter;
+
 /**
  * SvgIcon engine that supports loading from memory buffer
  */
@@ -63,8 +155,143 @@ class CSVGIconEngine : public QIconEngine
 private:
 	QByteArray m_SvgTemplate;
 	QByteArray m_SvgContent; ///< memory buffer with SVG data load from file
+	QByteArray m_DisabledSvgContent;///< empty if style has no disabled icon colors
+	QByteArray m_SelectedSvgContent;///< empty if style has no selected icon colors
+	QHash<quint64, QPixmap> m_Pixmaps;///< rendered pixmaps per pixel size, mode and scale
+	QHash<int, QPicture> m_Pictures;///< recorded vector drawing commands per mode
+	QSizeF m_PictureSize;///< the SVG size the pictures have been recorded with
+	bool m_Outdated = false;///< the SVG content has the colors of the last theme
 	QtAdvancedStylesheet* m_AdvancedStyleheet = nullptr;
 
+	/**
+	 * Returns the SVG content to use for the given mode
+	 */
+	const QByteArray& svgContent(QIcon::Mode Mode) const
+	{
+		if (Mode == QIcon::Disabled && !m_DisabledSvgContent.isEmpty())
+		{
+			return m_DisabledSvgContent;
+		}
+		if (Mode == QIcon::Selected && !m_SelectedSvgContent.isEmpty())
+		{
+			return m_SelectedSvgContent;
+		}
+		return m_SvgContent;
+	}
+
+	/**
+	 * Returns the cached pixmap for the given logical size, mode and scale
+	 * or renders it, if it is not in the cache
+	 */
+	QPixmap cachedPixmap(const QSize& Size, QIcon::Mode Mode, qreal Scale)
+	{
+		if (Mode == QIcon::Active)
+		{
+			Mode = QIcon::Normal;
+		}
+		if (m_Outdated)
+		{
+			update();
+		}
+
+		const QSize PixelSize = Size * Scale;
+		if (PixelSize.isEmpty())
+		{
+			return QPixmap();
+		}
+
+		const quint64 Key = pixmapCacheKey(PixelSize, Scale, Mode);
+		auto it = m_Pixmaps.constFind(Key);
+		if (it != m_Pixmaps.constEnd())
+		{
+			return it.value();
+		}
+
+		// Icons in zoomable views may be requested in many sizes - we keep
+		// the cache small
+		if (m_Pixmaps.size() >= 16)
+		{
+			m_Pixmaps.clear();
+		}
+		auto Pixmap = sharedPixmap(PixelSize, Mode, Scale);
+		Pixmap.setDevicePixelRatio(Scale);
+		m_Pixmaps.insert(Key, Pixmap);
+		return Pixmap;
+	}
+
+	/**
+	 * Returns the vector drawing commands of the SVG for the given mode.
+	 * The SVG is parsed and rendered into a QPicture once per theme and
+	 * mode. The picture contains the filled and stroked paths with resolved
+	 * colors and can be replayed at any size without walking the SVG
+	 * document again. Returns a null picture, if the SVG has no size.
+	 */
+	const QPicture& picture(QIcon::Mode Mode)
+	{
+		auto it = m_Pictures.constFind(Mode);
+		if (it != m_Pictures.constEnd())
+		{
+			return it.value();
+		}
+
+		QPicture Picture;
+		QSvgRenderer Renderer(svgContent(Mode));
+		if (Renderer.isValid() && !Renderer.defaultSize().isEmpty())
+		{
+			m_PictureSize = Renderer.defaultSize();
+			QPainter Painter(&Picture);
+			Renderer.render(&Painter, QRectF(QPointF(0, 0), m_PictureSize));
+		}
+		return m_Pictures.insert(Mode, Picture).value();
+	}
+
+	/**
+	 * Renders the SVG for the given mode into a pixmap with the given size
+	 * in device pixels
+	 */
+	QPixmap renderPixmap(const QSize& PixelSize, QIcon::Mode Mode)
+	{
+		QImage Image(PixelSize, QImage::Format_ARGB32_Premultiplied);
+		Image.fill(Qt::transparent);
+		{
+			QPainter Painter(&Image);
+			Painter.setRenderHint(QPainter::Antialiasing);
+			Painter.setRenderHint(QPainter::SmoothPixmapTransform);
+			const auto& Picture = picture(Mode);
+			if (Picture.isNull())
+			{
+				QSvgRenderer Renderer(svgContent(Mode));
+				Renderer.render(&Painter, QRect(QPoint(0, 0), PixelSize));
+			}
+			else
+			{
+				Painter.scale(PixelSize.width() / m_PictureSize.width(),
+					PixelSize.height() / m_PictureSize.height());
+				Painter.drawPicture(0, 0, Picture);
+			}
+		}
+		auto Pixmap = QPixmap::fromImage(Image, Qt::NoFormatConversion);
+
+		// If the style does not provide disabled icon colors, we fall back
+		// to the generic disabled icon generation of the application style
+		auto Application = qobject_cast<QApplication*>(QCoreApplication::instance());
+		if (Mode == QIcon::Disabled && m_DisabledSvgContent.isEmpty() && Application)
+		{
+			QStyleOption Option(0);
+			Option.palette = QApplication::palette();
+			Pixmap = QApplication::style()->generatedIconPixmap(QIcon::Disabled,
+				Pixmap, &Option);
+		}
+		return Pixmap;
+	}
+
+	/**
+	 * Returns the pixmap from the shared icon cache, if it is enabled.
+	 * Renders the pixmap and adds it to the shared icon cache, if the cache
+	 * does not contain it yet.
+	 */
+	QPixmap sharedPixmap(const QSize& PixelSize, QIcon::Mode Mode, qreal Scale);
+
 public:
 	/**
 	 * Creates an icon engine with the given SVG content an assigned
@@ -78,6 +305,43 @@ public:
 		IconEngineInstances->insert(this);
 	}
 
+	/**
+	 * Creates an icon engine from the data of a preloaded icon without
+	 * recoloring the SVG data again
+	 */
+	CSVGIconEngine(const PreloadedIcon& Icon, QtAdvancedStylesheet* Stylesheet)
+		: m_SvgTemplate(Icon.SvgTemplate),
+		  m_SvgContent(Icon.SvgContent),
+		  m_DisabledSvgContent(Icon.DisabledSvgContent),
+		  m_SelectedSvgContent(Icon.SelectedSvgContent),
+		  m_AdvancedStyleheet(Stylesheet)
+	{
+		for (const auto& Image : Icon.Images)
+		{
+			m_Pixmaps.insert(Image.first, QPixmap::fromImage(Image.second));
+		}
+		IconEngineInstances->insert(this);
+	}
+
+	/**
+	 * Copy constructor used by clone() - the copy needs to be registered
+	 * to get theme updates
+	 */
+	CSVGIconEngine(const CSVGIconEngine& Other)
+		: QIconEngine(Other),
+		  m_SvgTemplate(Other.m_SvgTemplate),
+		  m_SvgContent(Other.m_SvgContent),
+		  m_DisabledSvgContent(Other.m_DisabledSvgContent),
+		  m_SelectedSvgContent(Other.m_SelectedSvgContent),
+		  m_Pixmaps(Other.m_Pixmaps),
+		  m_Pictures(Other.m_Pictures),
+		  m_PictureSize(Other.m_PictureSize),
+		  m_Outdated(Other.m_Outdated),
+		  m_AdvancedStyleheet(Other.m_AdvancedStyleheet)
+	{
+		IconEngineInstances->insert(this);
+	}
+
 	/**
 	 * Removes itself from the set of instances
 	 */
@@ -92,11 +356,7 @@ public:
 	/**
 	 * Update the SVG content with the current theme icon colors
 	 */
-	void update()
-	{
-		m_SvgContent = m_SvgTemplate;
-		m_AdvancedStyleheet->replaceSvgColors(m_SvgContent);
-	}
+	void update();
 
 	/**
 	 * Calls update for all Icon engine instances
@@ -109,14 +369,54 @@ public:
 		}
 	}
 
+	/**
+	 * Marks all icon engine instances as outdated. An outdated engine is
+	 * updated when it is painted or by updateOutdatedIcons()
+	 */
+	static void invalidateAllIcons()
+	{
+		for (auto Engine : *IconEngineInstances)
+		{
+			Engine->m_Outdated = true;
+			Engine->m_Pixmaps.clear();
+			Engine->m_Pictures.clear();
+		}
+	}
+
+	/**
+	 * Updates up to MaxCount outdated icon engines. Returns true, if there
+	 * are no outdated icon engines left.
+	 */
+	static bool updateOutdatedIcons(int MaxCount)
+	{
+		for (auto Engine : *IconEngineInstances)
+		{
+			if (!Engine->m_Outdated)
+			{
+				continue;
+			}
+			if (!MaxCount--)
+			{
+				return false;
+			}
+			Engine->update();
+		}
+		return true;
+	}
+
+	/**
+	 * Adds the memory of all icon engines of the given stylesheet object
+	 * to Usage
+	 */
+	static void addMemoryUsage(const QtAdvancedStylesheet* Stylesheet,
+		QtAdvancedStylesheet::MemoryUsage& Usage);
+
 	virtual void paint(QPainter *painter, const QRect &rect, QIcon::Mode mode,
 	    QIcon::State state) override
 	{
-		Q_UNUSED(mode);
 		Q_UNUSED(state);
-
-		QSvgRenderer renderer(m_SvgContent);
-		renderer.render(painter, rect);
+		const qreal Scale = painter->device() ? painter->device()->devicePixelRatioF() : 1.0;
+		painter->drawPixmap(rect, cachedPixmap(rect.size(), mode, Scale));
 	}
 
 	virtual QIconEngine* clone() const override
@@ -127,18 +427,27 @@ public:
 	virtual QPixmap pixmap(const QSize &size, QIcon::Mode mode,
 	    QIcon::State state) override
 	{
-		// This function is necessary to create an EMPTY pixmap. It's called always
-		// before paint()
-		QImage img(size, QImage::Format_ARGB32);
-		img.fill(qRgba(0, 0, 0, 0));
-		QPixmap pix = QPixmap::fromImage(img, Qt::NoFormatConversion);
+		Q_UNUSED(state);
+		// QIcon passes the size in device pixels for the device pixel ratio
+		// of the application. We render with this ratio like paint() does,
+		// so both share their cached pixmaps.
+		const qreal Scale = qApp ? qApp->devicePixelRatio() : 1.0;
+		const QSize LogicalSize = size / Scale;
+		if (Scale > 1.0 && LogicalSize * Scale == size)
 		{
-			QPainter painter(&pix);
-			QRect r(QPoint(0.0, 0.0), size);
-			this->paint(&painter, r, mode, state);
+			return cachedPixmap(LogicalSize, mode, Scale);
 		}
-		return pix;
+		return cachedPixmap(size, mode, 1.0);
+	}
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+	virtual QPixmap scaledPixmap(const QSize &size, QIcon::Mode mode,
+	    QIcon::State state, qreal scale) override
+	{
+		Q_UNUSED(state);
+		return cachedPixmap(size, mode, scale);
 	}
+#endif
 };
 
 
@@ -211,6 +520,22 @@ static void insertIntoMap(QMap<Key, T>& Map, const QMap<Key, T> &map)
 }
 
 
+/**
+ * Returns the key of the style json icon colors section for the given
+ * icon mode
+ */
+static QString iconColorsJsonKey(QIcon::Mode Mode)
+{
+	switch (Mode)
+	{
+	case QIcon::Disabled: return "icon_colors_disabled";
+	case QIcon::Selected: return "icon_colors_selected";
+	default:
+		return "icon_colors";
+	}
+}
+
+
 /**
  * Returns the color group string for a given QPalette::ColorGroup
  */
@@ -229,18 +554,233 @@ static QString colorGroupString(QPalette::ColorGroup ColorGroup)
 }
 
 
+/**
+ * Adds all theme variables that are referenced by the color values of the
+ * given json object to the Variables set
+ */
+static void collectReferencedVariables(const QJsonObject& JsonObject, QSet<QString>& Variables)
+{
+	for (auto itc = JsonObject.constBegin(); itc != JsonObject.constEnd(); ++itc)
+	{
+		if (itc.value().isObject())
+		{
+			collectReferencedVariables(itc.value().toObject(), Variables);
+			continue;
+		}
+
+		auto Value = itc.value().toString();
+		if (!Value.isEmpty() && !Value.startsWith('#'))
+		{
+			Variables.insert(Value);
+		}
+	}
+}
+
+
+/**
+ * Parses the given UTF-8 stylesheet template. The function calls
+ * onText(const char* Text, int Size) for each literal text segment and
+ * onVariable(const QByteArray& Variable, float Opacity) for each
+ * "{{variable}}" or "{{variable|opacity(0.5)}}" segment. If the variable has
+ * no opacity, then Opacity is -1.
+ */
+template <class TextHandler, class VariableHandler>
+static void parseStyleTemplate(const QByteArray& Template, TextHandler onText,
+	VariableHandler onVariable)
+{
+	static const QByteArray OpacityStr("|opacity(");
+	int Pos = 0;
+	while (true)
+	{
+		const int Start = Template.indexOf("{{", Pos);
+		const int End = (Start < 0) ? -1 : Template.indexOf("}}", Start + 2);
+		if (End < 0)
+		{
+			if (Pos < Template.size())
+			{
+				onText(Template.constData() + Pos, Template.size() - Pos);
+			}
+			return;
+		}
+
+		if (Start > Pos)
+		{
+			onText(Template.constData() + Pos, Start - Pos);
+		}
+
+		auto Variable = Template.mid(Start + 2, End - Start - 2);
+		float Opacity = -1;
+		const int OpacityIndex = Variable.indexOf(OpacityStr);
+		if (OpacityIndex >= 0 && Variable.endsWith(')'))
+		{
+			const int ValueIndex = OpacityIndex + OpacityStr.size();
+			Opacity = Variable.mid(ValueIndex, Variable.size() - ValueIndex - 1).toFloat();
+			Variable.truncate(OpacityIndex);
+		}
+		onVariable(Variable, Opacity);
+		Pos = End + 2;
+	}
+}
+
+
+/**
+ * Returns the given data as C string literal for the generated sources of
+ * compiled styles. Long data is split into several literals.
+ */
+static QByteArray cStringLiteral(const QByteArray& Data)
+{
+	QByteArray Result = "\"";
+	int LineSize = 0;
+	for (char c : Data)
+	{
+		switch (c)
+		{
+		case '\\': Result += "\\\\"; break;
+		case '"': Result += "\\\""; break;
+		case '?': Result += "\\?"; break;// avoids trigraphs
+		case '\n': Result += "\\n"; break;
+		case '\r': Result += "\\r"; break;
+		case '\t': Result += "\\t"; break;
+		default:
+			if (uchar(c) < 0x20 || uchar(c) >= 0x7f)
+			{
+				// Always use three octal digits to separate the escape
+				// sequence from following digits
+				Result += '\\' + QByteArray::number(uchar(c), 8).rightJustified(3, '0');
+			}
+			else
+			{
+				Result += c;
+			}
+		}
+
+		if (c == '\n' || ++LineSize >= 100)
+		{
+			Result += "\"\n\t\"";
+			LineSize = 0;
+		}
+	}
+	Result += '"';
+	return Result;
+}
+
+
+/**
+ * Returns the pointer and count arguments for the given array of a
+ * compiled style or "nullptr, 0" if the array is empty
+ */
+static QByteArray cArrayReference(const QByteArray& Name, int Count)
+{
+	return Count ? (Name + ", " + QByteArray::number(Count)) : QByteArray("nullptr, 0");
+}
+
+
+/**
+ * Returns the file name of the PNG file for the given SVG file name and
+ * scale - e.g. checkbox.png for scale 1 and checkbox@2x.png for scale 2
+ */
+static QString rasterFileName(const QString& SvgFilename, qreal Scale)
+{
+	const auto BaseName = SvgFilename.endsWith(".svg", Qt::CaseInsensitive)
+		? SvgFilename.left(SvgFilename.size() - 4) : SvgFilename;
+	return qFuzzyCompare(Scale, 1) ? BaseName + ".png"
+		: BaseName + "@" + QString::number(Scale) + "x.png";
+}
+
+
+/**
+ * Maps the path of a generated PNG resource like "primary/checkbox@2x.png"
+ * to the path of its SVG resource "primary/checkbox.svg". Returns all other
+ * paths unchanged.
+ */
+static QString svgResourcePath(const QString& ResourcePath)
+{
+	static const QRegularExpression RasterSuffix("(@[0-9.]+x)?\\.png$");
+	auto Match = RasterSuffix.match(ResourcePath);
+	return Match.hasMatch() ? ResourcePath.left(Match.capturedStart()) + ".svg"
+		: ResourcePath;
+}
+
+
+/**
+ * Returns the heap memory of the given data or 0, if the data has already
+ * been counted. Data that is shared by several implicitly shared copies is
+ * counted only once.
+ */
+static qint64 uncountedBytes(const QByteArray& Data, QSet<const char*>& CountedData)
+{
+	if (!Data.capacity() || CountedData.contains(Data.constData()))
+	{
+		return 0;
+	}
+	CountedData.insert(Data.constData());
+	return Data.capacity();
+}
+
+
+/**
+ * Returns the heap memory of the keys and values of the given map
+ */
+static qint64 stringMapBytes(const QMap<QString, QString>& Map)
+{
+	qint64 Bytes = 0;
+	for (auto it = Map.constBegin(); it != Map.constEnd(); ++it)
+	{
+		Bytes += (it.key().capacity() + it.value().capacity()) * qint64(sizeof(QChar));
+	}
+	return Bytes;
+}
+
+
 /**
  * Private data class of CAdvancedStylesheet class (pimpl)
  */
 struct QtAdvancedStylesheetPrivate
 {
+	/**
+	 * The stages of the updateStylesheet() pipeline
+	 */
+	enum eUpdateStage
+	{
+		PaletteStage = 0x01,
+		ResourcesStage = 0x02,
+		IconsStage = 0x04,
+		StylesheetStage = 0x08
+	};
+
+	/**
+	 * The priorities of deferred work
+	 */
+	enum eDeferredPriority
+	{
+		HighPriority,
+		NormalPriority,
+		LowPriority
+	};
+
+	/**
+	 * Work that is done in small time slices when the event loop is idle
+	 */
+	struct DeferredTask
+	{
+		int Id;
+		QString Key;///< a new task with the same key replaces the task
+		int Priority;
+		std::function<bool()> Work;///< does a part of the work and returns true, if finished
+	};
+
+	/**
+	 * Maximum duration of deferred work per event loop iteration
+	 */
+	static const int DeferredWorkTimeSliceMs = 4;
+
 	QtAdvancedStylesheet *_this;
 	QString StylesDir;
 	QString OutputDir;
 	QMap<QString, QString> StyleVariables;
 	QMap<QString, QString> ThemeColors;
 	QMap<QString, QString> ThemeVariables;// theme variables contains StyleVariables and ThemeColors
-	QString Stylesheet;
+	QByteArray StylesheetUtf8;///< the generated stylesheet
 	QString CurrentStyle;
 	QString CurrentTheme;
 	QString DefaultTheme;
@@ -256,7 +796,67 @@ struct QtAdvancedStylesheetPrivate
 	QStringList Styles;
 	QStringList Themes;
 	bool IsDarkTheme = false;
-	mutable tColorReplaceList IconColorReplaceList;
+	mutable QMap<int, tColorReplaceList> IconColorReplaceLists;///< icon color replace list per QIcon::Mode
+	QString IconUrlPrefix;
+	QString RegisteredIconUrlPrefix;///< prefix of the registered search path
+	QString RegisteredIconSearchPath;///< search path entry owned by this instance
+	bool SharedOutputCache = false;
+	QString OutputCacheKey;///< key of the shared output cache entry of the current theme
+	QAtomicInt ThemeGeneration;
+
+	// The recolor data is published on each stylesheet update and may be
+	// accessed from any thread while holding the RecolorMutex
+	mutable QMutex RecolorMutex;
+	QString RecolorResourceDir;
+	QHash<QString, tColorReplaceList> RecolorVariants;
+	tColorReplaceList RecolorIconColors;
+	int RecolorGeneration = 0;
+	mutable QHash<QString, QByteArray> RecolorCache;
+	QHash<QString, QByteArray> RecolorTemplates;///< resource templates of a compiled style
+	QString RecolorOutputDir;
+	bool RecolorLazy = false;
+	QSet<QString> GeneratedResources;///< resources generated in lazy mode
+	QVector<qreal> RecolorRasterScales;
+	QSize RecolorRasterSize;
+	bool RecolorOptimizeSvg = false;
+
+	// The theme snapshot is replaced on each committed update. It is only
+	// accessed via std::atomic_load() and std::atomic_store(). Readers only
+	// load it, if SnapshotGeneration changed.
+	const int InstanceId = StylesheetInstanceCounter.fetchAndAddRelaxed(1) + 1;
+	tThemeSnapshotPtr Snapshot;
+	QAtomicInt SnapshotGeneration;
+	mutable QHash<QString, QPalette> PaletteCache;///< generated palettes per palette color state
+	QVector<QPalette::ColorRole> ChangedPaletteRoles;
+	bool StyleDirty = true;///< the style changed since the last update
+	bool OutputDirty = true;///< output dir or icon URL prefix changed since the last update
+	QSet<QString> DirtyVariables;///< variables changed since the last update
+	int TransactionLevel = 0;
+	QtAdvancedStylesheet::ChangeFlags TransactionChanges;
+	const CompiledStyle* Compiled = nullptr;///< the current style, if it is a compiled style
+	bool LazyResourceGeneration = false;
+	QVector<qreal> RasterScales;///< device pixel ratios of the generated PNG resources
+	QSize RasterSize;///< logical size of the PNG resources or invalid for the SVG size
+	bool SvgOptimization = false;
+	CSvgOptimizer::Statistics SvgOptimizationStatistics;///< savings of the last resource generation
+	QSet<QString> StylesheetReferences;///< resources referenced by the generated stylesheet
+	QSet<QString> TemplateReferences;///< resources referenced by processed stylesheet templates
+	bool LivePreview = false;
+	bool LivePreviewStylesheetDirty = false;
+	QMap<QString, QString> LivePreviewPending;///< variables that wait for the next frame
+	QMap<QString, QString> LivePreviewSavedVariables;///< restored by cancelLivePreview()
+	QMap<QString, QString> LivePreviewSavedColors;
+	QTimer* LivePreviewFrameTimer = nullptr;
+	QTimer* LivePreviewPauseTimer = nullptr;
+	bool DeferredWork = false;
+	QVector<DeferredTask> DeferredTasks;///< sorted by priority
+	int DeferredTaskCounter = 0;
+	QTimer* DeferredWorkTimer = nullptr;
+	QSharedPointer<CSharedIconCache> SharedIconCache;
+	QStringList VariableIds;///< variable name per id for the id based accessors
+	mutable QVector<QString> VariableIdValues;
+	mutable QVector<QColor> VariableIdColors;
+	mutable bool VariableIdTablesDirty = true;
 
 	/**
 	 * Private data constructor
@@ -274,83 +874,385 @@ struct QtAdvancedStylesheetPrivate
 	bool exportInternalStylesheet(const QString& Filename);
 
 	/**
-	 * Store the given stylesheet
+	 * Store the given stylesheet in the given output path or in the current
+	 * style output path, if OutputPath is empty
 	 */
-	bool storeStylesheet(const QString& Stylesheet, const QString& Filename);
+	bool storeStylesheet(const QByteArray& Stylesheet, const QString& Filename,
+		const QString& OutputPath = QString());
 
 	/**
-	 * Parse a list of theme variables
+	 * Writes the given content into a temporary file and then atomically
+	 * renames it to Filename. Readers never see half written files.
 	 */
-	bool parseVariablesFromXml(QXmlStreamReader& s, const QString& VariableTagName,
-		QMap<QString, QString>& Variable);
+	bool writeFileAtomic(const QString& Filename, const QByteArray& Content,
+		QString* ErrorString = nullptr);
 
 	/**
-	 * Parse the theme file for
+	 * Renders the given SVG content into one PNG file per scale next to the
+	 * given SVG file. The function does not access any members and may be
+	 * called from worker threads.
 	 */
-	bool parseThemeFile(const QString& ThemeFilename);
+	bool writeRasterResources(const QString& SvgFilename, const QByteArray& Content,
+		const QVector<qreal>& Scales, const QSize& Size, QString* ErrorString = nullptr);
 
 	/**
-	 * Parse the style JSON file
+	 * Calculates the key of the shared output cache entry from the style,
+	 * the theme variables and the modification times of the style files
 	 */
-	bool parseStyleJsonFile();
+	QString calculateOutputCacheKey() const;
 
 	/**
-	 * Creates an Rgba color from a given color and an opacity value in the
-	 * range from 0 (transparent) to 1 (opaque)
+	 * Updates the OutputCacheKey and the icon search path, if the shared
+	 * output cache is enabled
 	 */
-	QString rgbaColor(const QString& RgbColor, float Opacity);
+	void updateOutputCacheKey();
 
 	/**
-	 *	Replace the stylesheet variables in the given template
+	 * Returns the path of the file that marks a complete published shared
+	 * output cache entry
 	 */
-	void replaceStylesheetVariables(QString& Template);
+	QString sharedOutputStampFile() const;
 
 	/**
-	 * Register the style fonts to the font database
+	 * Locks the shared output cache entry of the current cache key. Only
+	 * the process that holds the lock generates the output of the entry.
+	 * Returns nullptr and sets the error, if locking failed.
 	 */
-	void addFonts(QDir* Dir = nullptr);
+	std::unique_ptr<QLockFile> lockSharedOutput();
 
 	/**
-	 * Generate the resources for the variuous states
+	 * Writes the stamp file that marks the shared output cache entry as
+	 * complete. Call this after the resources and the stylesheet have been
+	 * written.
 	 */
-	bool generateResourcesFor(const QString& SubDir,
-		const QJsonObject& JsonObject, const QFileInfoList& Entries);
+	bool publishSharedOutput();
 
 	/**
-	 * Replace the in the given content the template color string with the
-	 * theme color string
+	 * Publishes the color replace lists of the current theme for the
+	 * thread safe SVG recoloring functions, clears the recolor cache and
+	 * increments the theme generation
 	 */
-	void replaceColor(QByteArray& Content, const QString& TemplateColor,
-		const QString& ThemeColor) const;
+	void publishRecolorData();
 
 	/**
-	 * Set error code and error string
+	 * Publishes an immutable snapshot of the current theme state for
+	 * readers in other threads
 	 */
-	void setError(QtAdvancedStylesheet::eError Error, const QString& ErrorString);
+	void publishThemeSnapshot();
 
 	/**
-	 * Convenience function to ease clearing the error
+	 * Updates the values and parsed colors of the id based accessors
 	 */
-	void clearError()
-	{
-		setError(QtAdvancedStylesheet::NoError, QString());
-	}
+	void updateVariableIdTables() const;
 
 	/**
-	 * Parse palette from JSON file
+	 * Adds deferred work to the queue. The work is called repeatedly when
+	 * the event loop is idle until it returns true.
 	 */
-	void parsePaletteFromJson();
+	void enqueueDeferredWork(const QString& Key, int Priority, std::function<bool()> Work);
 
 	/**
-	 * Parse palette color group from the given palette json parameters
+	 * Runs deferred work until the queue is empty or until the time slice
+	 * is exhausted. A negative time slice runs all work. Returns true, if the
+	 * queue is empty.
 	 */
-	void parsePaletteColorGroup(QJsonObject& jPalette, QPalette::ColorGroup ColorGroup);
+	bool runDeferredWork(qint64 TimeSliceNs);
 
 	/**
-	 * Use this function to access the icon color replace list, to ensure, that
-	 * is is properly initialized
+	 * Removes all deferred work from the queue without running it
 	 */
-	const tColorReplaceList& iconColorReplaceList() const;
+	void cancelDeferredWork();
+
+	/**
+	 * Returns true, if only the referenced resources are generated eagerly.
+	 * A published shared output cache entry needs to be complete, because
+	 * other processes use it without the lock - so lazy generation is not
+	 * used with a shared output cache.
+	 */
+	bool lazyResources() const
+	{
+		return LazyResourceGeneration && !SharedOutputCache;
+	}
+
+	/**
+	 * Returns true, if the resources that are not referenced by the
+	 * stylesheets are generated when the event loop is idle
+	 */
+	bool deferResources() const
+	{
+		return DeferredWork && !LazyResourceGeneration && !SharedOutputCache;
+	}
+
+	/**
+	 * Enqueues the generation of all resources that have not been generated
+	 * yet
+	 */
+	void deferResourceGeneration();
+
+	/**
+	 * Thread safe function that replaces the colors of the given SVG
+	 * template with the given list and stores the result with the given key
+	 * in the recolor cache. If the template is null, it is loaded from the
+	 * given file.
+	 */
+	QByteArray recoloredSvg(const QString& CacheKey, const QString& Filename,
+		const QByteArray& Template, const tColorReplaceList& ColorReplaceList,
+		int Generation) const;
+
+	/**
+	 * Generate the resources for all variants defined in the style json file
+	 */
+	bool generateAllResources();
+
+	/**
+	 * Returns the SVG resource templates of the current style. If FileNames
+	 * is given, only the templates with the given file names are loaded.
+	 */
+	tResourceTemplates resourceTemplates(const QSet<QString>* FileNames = nullptr) const;
+
+	/**
+	 * Optimizes the given resource templates, if SVG optimization is enabled
+	 * and adds the savings to Statistics
+	 */
+	void optimizeResourceTemplates(tResourceTemplates& Templates,
+		CSvgOptimizer::Statistics* Statistics = nullptr) const;
+
+	/**
+	 * Returns the file names of all SVG resource templates of the current style
+	 */
+	QStringList resourceTemplateNames() const;
+
+	/**
+	 * Returns all resources ("variant/file.svg") that are referenced via
+	 * icon URLs in the given stylesheet
+	 */
+	QSet<QString> findReferencedResources(const QByteArray& Stylesheet) const;
+
+	/**
+	 * Generates all resources that are referenced by the given set and that
+	 * have not been generated yet
+	 */
+	void generateMissingResources(const QSet<QString>& Resources);
+
+	/**
+	 * Generates the referenced resources in lazy mode and removes the
+	 * outdated resources of the last generation
+	 */
+	bool generateReferencedResources(const tResourceTemplates& Templates);
+
+	/**
+	 * Loads the style data from the tables of the Compiled style
+	 */
+	void loadCompiledStyle();
+
+	/**
+	 * Loads the given theme from the tables of the Compiled style
+	 */
+	bool loadCompiledTheme(const QString& Theme);
+
+	/**
+	 * Register the fonts of the Compiled style to the font database
+	 */
+	void addCompiledFonts();
+
+	/**
+	 * Marks the style as changed, registers the style fonts and emits the
+	 * style change signals
+	 */
+	void finishStyleChange();
+
+	/**
+	 * Parse a list of theme variables
+	 */
+	bool parseVariablesFromXml(QXmlStreamReader& s, const QString& VariableTagName,
+		QMap<QString, QString>& Variable);
+
+	/**
+	 * Parse the theme file for
+	 */
+	bool parseThemeFile(const QString& ThemeFilename);
+
+	/**
+	 * Parse the style JSON file
+	 */
+	bool parseStyleJsonFile();
+
+	/**
+	 * Creates an Rgba color from a given color and an opacity value in the
+	 * range from 0 (transparent) to 1 (opaque)
+	 */
+	QString rgbaColor(const QString& RgbColor, float Opacity);
+
+	/**
+	 * Renders the template segments that the given parse function passes to
+	 * its text and variable handlers into a single UTF-8 buffer. The buffer
+	 * is sized in a first pass, so rendering needs no reallocations.
+	 */
+	template <class SegmentParser>
+	QByteArray renderSegments(SegmentParser parseSegments);
+
+	/**
+	 * Replaces the stylesheet variables in the given UTF-8 template
+	 */
+	QByteArray renderStyleTemplate(const QByteArray& Template);
+
+	/**
+	 * Renders the template segments of the compiled style
+	 */
+	QByteArray renderCompiledTemplate();
+
+	/**
+	 * Register the style fonts to the font database
+	 */
+	void addFonts(QDir* Dir = nullptr);
+
+	/**
+	 * Registers the given font file, if it is not registered yet
+	 */
+	static void addApplicationFont(const QString& FontFilename);
+
+	/**
+	 * Registers the current style output path as search path for the
+	 * IconUrlPrefix. The search path entry that has been registered before
+	 * by this instance is replaced.
+	 */
+	void updateIconSearchPath();
+
+	/**
+	 * Removes the search path entry registered by this instance
+	 */
+	void removeIconSearchPath();
+
+	/**
+	 * Sets IconUrlPrefix and updates the users of the old and the new prefix
+	 */
+	void assignIconUrlPrefix(const QString& Prefix);
+
+	/**
+	 * Replaces the default "icon:" URL prefix in the given stylesheet with
+	 * the configured IconUrlPrefix
+	 */
+	void replaceIconUrlPrefix(QByteArray& Stylesheet) const;
+
+	/**
+	 * Generate the resources for the variuous states
+	 */
+	bool generateResourcesFor(const QString& SubDir,
+		const QJsonObject& JsonObject, const tResourceTemplates& Templates);
+
+	/**
+	 * Replace the in the given content the template color string with the
+	 * theme color string
+	 */
+	void replaceColor(QByteArray& Content, const QString& TemplateColor,
+		const QString& ThemeColor) const;
+
+	/**
+	 * Set error code and error string
+	 */
+	void setError(QtAdvancedStylesheet::eError Error, const QString& ErrorString);
+
+	/**
+	 * Convenience function to ease clearing the error
+	 */
+	void clearError()
+	{
+		setError(QtAdvancedStylesheet::NoError, QString());
+	}
+
+	/**
+	 * Parse palette from JSON file
+	 */
+	void parsePaletteFromJson();
+
+	/**
+	 * Parse palette color group from the given palette json parameters
+	 */
+	void parsePaletteColorGroup(QJsonObject& jPalette, QPalette::ColorGroup ColorGroup);
+
+	/**
+	 * Adds all variables with different values in Old and New to the
+	 * DirtyVariables
+	 */
+	void markChangedVariables(const QMap<QString, QString>& Old,
+		const QMap<QString, QString>& New);
+
+	/**
+	 * Returns the update stages that need to run because their inputs
+	 * changed since the last successful updateStylesheet() call
+	 */
+	int dirtyUpdateStages() const;
+
+	/**
+	 * Returns the variables that are used by the palette
+	 */
+	QSet<QString> paletteVariables() const;
+
+	/**
+	 * Returns the variables that are used by the icon colors of all modes
+	 */
+	QSet<QString> iconVariables() const;
+
+	/**
+	 * Applies the pending live preview variables. Only the palette and the
+	 * icon colors are updated.
+	 */
+	void applyLivePreviewFrame();
+
+	/**
+	 * Applies the pending live preview variables and regenerates the
+	 * stylesheet in memory
+	 */
+	void applyLivePreviewPause();
+
+	/**
+	 * Stops the live preview timers and leaves the live preview mode
+	 */
+	void stopLivePreview();
+
+	/**
+	 * Runs all dirty update stages. StylesheetUpdated is set to true, if
+	 * any stage has been run.
+	 */
+	bool runUpdateStages(bool& StylesheetUpdated);
+
+	/**
+	 * Clears all dirty flags after a successful update
+	 */
+	void clearDirtyState()
+	{
+		StyleDirty = false;
+		OutputDirty = false;
+		DirtyVariables.clear();
+	}
+
+	/**
+	 * Returns the key for the PaletteCache that identifies the current
+	 * palette relevant colors and the given base palette
+	 */
+	QString paletteCacheKey(const QPalette& BasePalette) const;
+
+	/**
+	 * Returns the color roles that differ in at least one color group
+	 */
+	static QVector<QPalette::ColorRole> changedColorRoles(const QPalette& From,
+		const QPalette& To);
+
+	/**
+	 * Use this function to access the icon color replace list, to ensure, that
+	 * is is properly initialized.
+	 * For the Disabled and Selected modes, the function returns an empty
+	 * list, if the style does not define icon colors for these modes.
+	 */
+	const tColorReplaceList& iconColorReplaceList(QIcon::Mode Mode = QIcon::Normal) const;
+
+	/**
+	 * Gives the icon engine access to the private data
+	 */
+	static QtAdvancedStylesheetPrivate* get(QtAdvancedStylesheet* Stylesheet)
+	{
+		return Stylesheet->d;
+	}
 
 	/**
 	 * Parse a color replace list from the given JsonObject
@@ -360,598 +1262,3023 @@ struct QtAdvancedStylesheetPrivate
 
 
 //============================================================================
-QtAdvancedStylesheetPrivate::QtAdvancedStylesheetPrivate(
-    QtAdvancedStylesheet *_public) :
-	_this(_public)
+QtAdvancedStylesheetPrivate::QtAdvancedStylesheetPrivate(
+    QtAdvancedStylesheet *_public) :
+	_this(_public),
+	Snapshot(std::make_shared<CThemeSnapshot>())
+{
+	// Each instance gets its own default prefix, so the search path entries
+	// of several instances do not hide each other
+	QString Prefix = "icon";
+	if (IconUrlPrefixUsers->contains(Prefix))
+	{
+		Prefix += QString::number(InstanceId);
+	}
+	assignIconUrlPrefix(Prefix);
+}
+
+
+//============================================================================
+void QtAdvancedStylesheetPrivate::setError(QtAdvancedStylesheet::eError Error,
+	const QString& ErrorString)
+{
+	this->Error = Error;
+	this->ErrorString = ErrorString;
+	if (Error != QtAdvancedStylesheet::NoError)
+	{
+		qDebug() << "CAdvancedStylesheet Error: " << Error << " " << ErrorString;
+	}
+}
+
+
+//============================================================================
+QString QtAdvancedStylesheetPrivate::rgbaColor(const QString& RgbColor, float Opacity)
+{
+	int Alpha = 255 * Opacity;
+	auto RgbaColor = RgbColor;
+	RgbaColor.insert(1, QString("%1").arg(Alpha, 2, 16, QChar('0')));
+	return RgbaColor;
+}
+
+
+//============================================================================
+template <class SegmentParser>
+QByteArray QtAdvancedStylesheetPrivate::renderSegments(SegmentParser parseSegments)
+{
+	QVector<QByteArray> Values;
+	int Size = 0;
+	parseSegments(
+		[&](const char*, int TextSize)
+		{
+			Size += TextSize;
+		},
+		[&](const QByteArray& Variable, float Opacity)
+		{
+			auto Value = _this->themeVariableValue(QString::fromUtf8(Variable));
+			if (Opacity >= 0)
+			{
+				Value = rgbaColor(Value, Opacity);
+			}
+			Values.append(Value.toUtf8());
+			Size += Values.last().size();
+		});
+
+	QByteArray Result;
+	Result.reserve(Size);
+	int ValueIndex = 0;
+	parseSegments(
+		[&](const char* Text, int TextSize)
+		{
+			Result.append(Text, TextSize);
+		},
+		[&](const QByteArray&, float)
+		{
+			Result.append(Values[ValueIndex++]);
+		});
+	return Result;
+}
+
+
+//============================================================================
+QByteArray QtAdvancedStylesheetPrivate::renderStyleTemplate(const QByteArray& Template)
+{
+	return renderSegments([&Template](const auto& onText, const auto& onVariable)
+	{
+		parseStyleTemplate(Template, onText, onVariable);
+	});
+}
+
+
+//============================================================================
+QByteArray QtAdvancedStylesheetPrivate::renderCompiledTemplate()
+{
+	return renderSegments([this](const auto& onText, const auto& onVariable)
+	{
+		for (int i = 0; i < Compiled->TemplateSegmentCount; ++i)
+		{
+			const auto& Segment = Compiled->TemplateSegments[i];
+			if (Segment.IsVariable)
+			{
+				onVariable(QByteArray::fromRawData(Segment.Text, Segment.Size), Segment.Opacity);
+			}
+			else
+			{
+				onText(Segment.Text, Segment.Size);
+			}
+		}
+	});
+}
+
+
+//============================================================================
+bool QtAdvancedStylesheetPrivate::generateStylesheet()
+{
+	QString TemplateFilePath;
+	if (Compiled)
+	{
+		if (!Compiled->TemplateSegmentCount)
+		{
+			return false;
+		}
+		TemplateFilePath = QString::fromUtf8(Compiled->CssTemplateName);
+		StylesheetUtf8 = renderCompiledTemplate();
+	}
+	else
+	{
+		auto CssTemplateFileName = JsonStyleParam.value("css_template").toString();
+		if (CssTemplateFileName.isEmpty())
+		{
+			return false;
+		}
+
+		TemplateFilePath = _this->currentStylePath() + "/" + CssTemplateFileName;
+		QFile TemplateFile(TemplateFilePath);
+		if (!TemplateFile.open(QIODevice::ReadOnly))
+		{
+			setError(QtAdvancedStylesheet::CssTemplateError, "Stylesheet folder "
+				"does not contain the CSS template file " + CssTemplateFileName);
+			return false;
+		}
+
+		// The template is mapped into memory and rendered directly into the
+		// UTF-8 stylesheet buffer without any intermediate UTF-16 copies.
+		// If mapping is not supported, we fall back to reading the file.
+		const auto TemplateSize = TemplateFile.size();
+		auto Mapped = TemplateSize ? TemplateFile.map(0, TemplateSize) : nullptr;
+		StylesheetUtf8 = Mapped
+			? renderStyleTemplate(QByteArray::fromRawData(
+				reinterpret_cast<const char*>(Mapped), int(TemplateSize)))
+			: renderStyleTemplate(TemplateFile.readAll());
+	}
+
+	replaceIconUrlPrefix(StylesheetUtf8);
+	StylesheetReferences = findReferencedResources(StylesheetUtf8);
+	if (LivePreview)
+	{
+		return true;
+	}
+	generateMissingResources(StylesheetReferences);
+	const auto Filename = QFileInfo(TemplateFilePath).baseName() + ".css";
+	// Other processes rely on the stylesheet of a published shared output
+	// cache entry, so it is never deferred in this mode
+	if (!DeferredWork || SharedOutputCache)
+	{
+		exportInternalStylesheet(Filename);
+		return true;
+	}
+
+	// The output path is resolved now - the output dir or the cache key
+	// may change before the task runs
+	const auto Content = StylesheetUtf8;
+	const auto OutputPath = _this->currentStyleOutputPath();
+	enqueueDeferredWork("stylesheet", LowPriority, [this, Content, Filename, OutputPath]()
+	{
+		storeStylesheet(Content, Filename, OutputPath);
+		return true;
+	});
+	return true;
+}
+
+
+//============================================================================
+bool QtAdvancedStylesheetPrivate::exportInternalStylesheet(const QString& Filename)
+{
+	// The cache key covers the style files and the theme variables, so a
+	// published stylesheet can be reused as it is
+	if (SharedOutputCache && QFile::exists(_this->currentStyleOutputPath() + "/" + Filename))
+	{
+		return true;
+	}
+	return storeStylesheet(this->StylesheetUtf8, Filename);
+}
+
+
+//============================================================================
+bool QtAdvancedStylesheetPrivate::storeStylesheet(const QByteArray& Stylesheet,
+	const QString& Filename, const QString& OutputPath)
+{
+	const auto Path = OutputPath.isEmpty() ? _this->currentStyleOutputPath() : OutputPath;
+	QDir().mkpath(Path);
+	QString OutputFilename = Path + "/" + Filename;
+	QString ErrorString;
+	if (!writeFileAtomic(OutputFilename, Stylesheet, &ErrorString))
+	{
+		setError(QtAdvancedStylesheet::CssExportError, "Exporting stylesheet "
+			+ Filename + " caused error: " + ErrorString);
+		return false;
+	}
+	return true;
+}
+
+
+//============================================================================
+bool QtAdvancedStylesheetPrivate::writeFileAtomic(const QString& Filename,
+	const QByteArray& Content, QString* ErrorString)
+{
+	QSaveFile OutputFile(Filename);
+	if (!OutputFile.open(QIODevice::WriteOnly)
+	 || OutputFile.write(Content) != Content.size()
+	 || !OutputFile.commit())
+	{
+		if (ErrorString)
+		{
+			*ErrorString = OutputFile.errorString();
+		}
+		return false;
+	}
+	return true;
+}
+
+
+//============================================================================
+bool QtAdvancedStylesheetPrivate::writeRasterResources(const QString& SvgFilename,
+	const QByteArray& Content, const QVector<qreal>& Scales, const QSize& Size,
+	QString* ErrorString)
+{
+	QSvgRenderer Renderer(Content);
+	const QSize LogicalSize = Size.isValid() ? Size : Renderer.defaultSize();
+	if (!Renderer.isValid() || LogicalSize.isEmpty())
+	{
+		if (ErrorString)
+		{
+			*ErrorString = "Invalid SVG data";
+		}
+		return false;
+	}
+
+	for (auto Scale : Scales)
+	{
+		QImage Image(LogicalSize * Scale, QImage::Format_ARGB32_Premultiplied);
+		Image.fill(Qt::transparent);
+		{
+			QPainter Painter(&Image);
+			Renderer.render(&Painter);
+		}
+
+		QByteArray Png;
+		QBuffer Buffer(&Png);
+		Buffer.open(QIODevice::WriteOnly);
+		if (!Image.save(&Buffer, "PNG"))
+		{
+			if (ErrorString)
+			{
+				*ErrorString = "Encoding PNG failed";
+			}
+			return false;
+		}
+		if (!writeFileAtomic(rasterFileName(SvgFilename, Scale), Png, ErrorString))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+//============================================================================
+QString QtAdvancedStylesheetPrivate::calculateOutputCacheKey() const
+{
+	QByteArray KeyData = CurrentStyle.toUtf8() + ';' + IconUrlPrefix.toUtf8() + ';';
+	for (auto Scale : RasterScales)
+	{
+		KeyData += QByteArray::number(Scale) + 'x';
+	}
+	KeyData += SvgOptimization ? "optimized;" : "";
+	KeyData += QByteArray::number(RasterSize.width()) + ','
+		+ QByteArray::number(RasterSize.height()) + ';';
+	KeyData += QJsonDocument(JsonStyleParam).toJson(QJsonDocument::Compact);
+	for (auto itc = ThemeVariables.constBegin(); itc != ThemeVariables.constEnd(); ++itc)
+	{
+		KeyData += itc.key().toUtf8() + '=' + itc.value().toUtf8() + ';';
+	}
+
+	// The data of a compiled style is part of the binary - so we use the
+	// template and the resources instead of the file modification times
+	if (Compiled)
+	{
+		for (int i = 0; i < Compiled->TemplateSegmentCount; ++i)
+		{
+			KeyData.append(Compiled->TemplateSegments[i].Text, Compiled->TemplateSegments[i].Size);
+		}
+		for (int i = 0; i < Compiled->ResourceCount; ++i)
+		{
+			KeyData.append(Compiled->Resources[i].Data, Compiled->Resources[i].Size);
+		}
+		auto Hash = QCryptographicHash::hash(KeyData, QCryptographicHash::Sha1);
+		return QString::fromLatin1(Hash.toHex().left(16));
+	}
+
+	// Changed style files on disk invalidate published entries
+	auto StyleFiles = QDir(_this->path(QtAdvancedStylesheet::ResourceTemplatesLocation))
+		.entryInfoList({"*.svg"}, QDir::Files, QDir::Name);
+	StyleFiles.append(QFileInfo(_this->currentStylePath() + "/"
+		+ JsonStyleParam.value("css_template").toString()));
+	for (const auto& FileInfo : StyleFiles)
+	{
+		KeyData += FileInfo.fileName().toUtf8() + ';'
+			+ QByteArray::number(FileInfo.lastModified().toMSecsSinceEpoch()) + ';'
+			+ QByteArray::number(FileInfo.size()) + ';';
+	}
+
+	auto Hash = QCryptographicHash::hash(KeyData, QCryptographicHash::Sha1);
+	return QString::fromLatin1(Hash.toHex().left(16));
+}
+
+
+//============================================================================
+void QtAdvancedStylesheetPrivate::updateOutputCacheKey()
+{
+	OutputCacheKey = SharedOutputCache ? calculateOutputCacheKey() : QString();
+	updateIconSearchPath();
+}
+
+
+//============================================================================
+QString QtAdvancedStylesheetPrivate::sharedOutputStampFile() const
+{
+	return _this->currentStyleOutputPath() + "/.published";
+}
+
+
+//============================================================================
+std::unique_ptr<QLockFile> QtAdvancedStylesheetPrivate::lockSharedOutput()
+{
+	const auto OutputPath = _this->currentStyleOutputPath();
+	QDir().mkpath(OutputPath);
+	std::unique_ptr<QLockFile> Lock(new QLockFile(OutputPath + ".lock"));
+	if (!Lock->lock())
+	{
+		setError(QtAdvancedStylesheet::ResourceGeneratorError, "Error "
+			"locking shared output cache " + OutputPath);
+		return nullptr;
+	}
+	return Lock;
+}
+
+
+//============================================================================
+bool QtAdvancedStylesheetPrivate::publishSharedOutput()
+{
+	QString ErrorString;
+	if (!writeFileAtomic(sharedOutputStampFile(), OutputCacheKey.toLatin1(), &ErrorString))
+	{
+		setError(QtAdvancedStylesheet::ResourceGeneratorError, "Error "
+			"publishing shared output cache " + _this->currentStyleOutputPath()
+			+ ": " + ErrorString);
+		return false;
+	}
+	return true;
+}
+
+
+//============================================================================
+void QtAdvancedStylesheetPrivate::updateIconSearchPath()
+{
+	if (CurrentStyle.isEmpty())
+	{
+		return;
+	}
+
+	const auto SearchPath = _this->currentStyleOutputPath();
+	if (RegisteredIconUrlPrefix == IconUrlPrefix && RegisteredIconSearchPath == SearchPath)
+	{
+		return;
+	}
+
+	// If the prefix did not change, we replace our entry in place to keep
+	// the lookup order of the other registered entries
+	auto SearchPaths = QDir::searchPaths(IconUrlPrefix);
+	int Index = (RegisteredIconUrlPrefix == IconUrlPrefix)
+		? SearchPaths.indexOf(RegisteredIconSearchPath) : -1;
+	if (Index < 0)
+	{
+		removeIconSearchPath();
+		SearchPaths = QDir::searchPaths(IconUrlPrefix);
+		SearchPaths.append(SearchPath);
+	}
+	else
+	{
+		SearchPaths[Index] = SearchPath;
+	}
+
+	QDir::setSearchPaths(IconUrlPrefix, SearchPaths);
+	RegisteredIconUrlPrefix = IconUrlPrefix;
+	RegisteredIconSearchPath = SearchPath;
+}
+
+
+//============================================================================
+void QtAdvancedStylesheetPrivate::removeIconSearchPath()
+{
+	if (RegisteredIconUrlPrefix.isEmpty())
+	{
+		return;
+	}
+
+	auto SearchPaths = QDir::searchPaths(RegisteredIconUrlPrefix);
+	SearchPaths.removeOne(RegisteredIconSearchPath);
+	QDir::setSearchPaths(RegisteredIconUrlPrefix, SearchPaths);
+	RegisteredIconUrlPrefix.clear();
+	RegisteredIconSearchPath.clear();
+}
+
+
+//============================================================================
+void QtAdvancedStylesheetPrivate::assignIconUrlPrefix(const QString& Prefix)
+{
+	auto& Users = *IconUrlPrefixUsers;
+	if (!IconUrlPrefix.isEmpty() && --Users[IconUrlPrefix] <= 0)
+	{
+		Users.remove(IconUrlPrefix);
+	}
+	IconUrlPrefix = Prefix;
+	if (!IconUrlPrefix.isEmpty())
+	{
+		Users[IconUrlPrefix]++;
+	}
+}
+
+
+//============================================================================
+void QtAdvancedStylesheetPrivate::replaceIconUrlPrefix(QByteArray& Stylesheet) const
+{
+	if (IconUrlPrefix == QLatin1String("icon"))
+	{
+		return;
+	}
+
+	Stylesheet.replace("url(icon:", "url(" + IconUrlPrefix.toUtf8() + ":");
+}
+
+
+//============================================================================
+void QtAdvancedStylesheetPrivate::addFonts(QDir* Dir)
+{
+	// I dont't know, if this is the right way to detect, if there are any
+	// widgets. The call to QFontDatabase::addApplicationFont() will crash, if
+	// there are no widgets
+	if (qApp->allWidgets().isEmpty())
+	{
+		return;
+	}
+
+	if (Compiled)
+	{
+		addCompiledFonts();
+		return;
+	}
+
+	if (!Dir)
+	{
+		QDir FontsDir(_this->path(QtAdvancedStylesheet::FontsLocation));
+		addFonts(&FontsDir);
+	}
+	else
+	{
+		auto Folders = Dir->entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+		for (auto Folder : Folders)
+		{
+			Dir->cd(Folder);
+			addFonts(Dir);
+			Dir->cdUp();
+		}
+
+		// The family that is used by the stylesheet is registered immediately,
+		// all other families when the event loop is idle
+		const auto FontFamily = QString(StyleVariables.value("font_family")).remove(' ');
+		QStringList DeferredFonts;
+		auto FontFiles = Dir->entryList({"*.ttf"}, QDir::Files);
+		for (auto Font : FontFiles)
+		{
+			QString FontFilename = Dir->absoluteFilePath(Font);
+			if (RegisteredFonts->contains(FontFilename))
+			{
+				continue;
+			}
+			if (DeferredWork && !FontFamily.isEmpty() && QFileInfo(Font)
+				.completeBaseName().section('-', 0, 0).compare(FontFamily, Qt::CaseInsensitive))
+			{
+				DeferredFonts.append(FontFilename);
+				continue;
+			}
+			addApplicationFont(FontFilename);
+		}
+
+		if (DeferredFonts.isEmpty())
+		{
+			return;
+		}
+		QSharedPointer<QStringList> Fonts(new QStringList(DeferredFonts));
+		enqueueDeferredWork("fonts:" + Dir->absolutePath(), LowPriority, [Fonts]()
+		{
+			addApplicationFont(Fonts->takeFirst());
+			return Fonts->isEmpty();
+		});
+	}
+}
+
+
+//============================================================================
+void QtAdvancedStylesheetPrivate::addApplicationFont(const QString& FontFilename)
+{
+	if (RegisteredFonts->contains(FontFilename))
+	{
+		return;
+	}
+	if (QFontDatabase::addApplicationFont(FontFilename) >= 0)
+	{
+		RegisteredFonts->insert(FontFilename);
+	}
+}
+
+
+//============================================================================
+bool QtAdvancedStylesheetPrivate::parseVariablesFromXml(
+	QXmlStreamReader& s, const QString& TagName, QMap<QString, QString>& Variables)
+{
+	while (s.readNextStartElement())
+	{
+		if (s.name() != TagName)
+		{
+			setError(QtAdvancedStylesheet::ThemeXmlError, "Malformed theme "
+                                "file - expected tag <" + TagName + "> instead of " + s.name().toString());
+			return false;
+		}
+		auto Name = s.attributes().value("name").toString();
+		if (Name.isEmpty())
+		{
+			setError(QtAdvancedStylesheet::ThemeXmlError, "Malformed theme file - "
+				"name attribute missing in <" + TagName + "> tag");
+			return false;
+		}
+
+		auto Value = s.readElementText(QXmlStreamReader::SkipChildElements);
+		if (Value.isEmpty())
+		{
+			setError(QtAdvancedStylesheet::ThemeXmlError, "Malformed theme file - "
+				"text of <" + TagName + "> tag is empty");
+			return false;
+		}
+
+		Variables.insert(Name, Value);
+	}
+
+	return true;
+}
+
+
+//============================================================================
+bool QtAdvancedStylesheetPrivate::parseThemeFile(const QString& Theme)
+{
+	QString ThemeFileName = _this->path(QtAdvancedStylesheet::ThemesLocation) + "/" + Theme;
+	QFile ThemeFile(ThemeFileName);
+	ThemeFile.open(QIODevice::ReadOnly);
+	QXmlStreamReader s(&ThemeFile);
+        s.readNextStartElement();
+        if (s.name() != QString("resources"))
+	{
+		setError(QtAdvancedStylesheet::ThemeXmlError, "Malformed theme file - "
+                        "expected tag <resources> instead of " + s.name().toString());
+		return false;
+	}
+
+	IsDarkTheme = (s.attributes().value("dark").toInt() == 1);
+    QMap<QString, QString> ColorVariables;
+	parseVariablesFromXml(s, "color", ColorVariables);
+	this->ThemeVariables = this->StyleVariables;
+	insertIntoMap(this->ThemeVariables, ColorVariables);
+	this->ThemeColors = ColorVariables;
+	VariableIdTablesDirty = true;
+	return true;
+}
+
+
+//============================================================================
+bool QtAdvancedStylesheetPrivate::parseStyleJsonFile()
+{
+	QDir Dir(_this->currentStylePath());
+	auto JsonFiles = Dir.entryInfoList({"*.json"}, QDir::Files);
+	if (JsonFiles.count() < 1)
+	{
+		setError(QtAdvancedStylesheet::StyleJsonError, "Stylesheet folder does "
+			"not contain a style json file");
+		return false;
+	}
+
+	if (JsonFiles.count() > 1)
+	{
+		setError(QtAdvancedStylesheet::StyleJsonError, "Stylesheet folder "
+			"contains multiple theme json files");
+		return false;
+	}
+
+	QFile StyleJsonFile(JsonFiles[0].absoluteFilePath());
+	StyleJsonFile.open(QIODevice::ReadOnly);
+
+	auto JsonData = StyleJsonFile.readAll();
+	QJsonParseError ParseError;
+	auto JsonDocument = QJsonDocument::fromJson(JsonData, &ParseError);
+	if (JsonDocument.isNull())
+	{
+		setError(QtAdvancedStylesheet::StyleJsonError, "Loading style json file "
+			"caused error: " + ParseError.errorString());
+		return false;
+	}
+
+	auto json = JsonStyleParam = JsonDocument.object();
+	StyleName = json.value("name").toString();
+	if (StyleName.isEmpty())
+	{
+		setError(QtAdvancedStylesheet::StyleJsonError, "No key \"name\" found "
+			"in style json file");
+		return false;
+	}
+
+	QMap<QString, QString> Variables;
+	auto jvariables = json.value("variables").toObject();
+	for (const auto& key : jvariables.keys())
+	{
+		Variables.insert(key, jvariables.value(key).toString());
+	}
+
+	StyleVariables = Variables;
+	IconFile = json.value("icon").toString();
+	parsePaletteFromJson();
+
+	DefaultTheme = json.value("default_theme").toString();
+	if (DefaultTheme.isEmpty())
+	{
+		setError(QtAdvancedStylesheet::StyleJsonError, "No key \"default_theme\" found "
+			"in style json file");
+		return false;
+	}
+
+	return true;
+}
+
+
+//============================================================================
+void QtAdvancedStylesheetPrivate::parsePaletteFromJson()
+{
+	PaletteBaseColor = QString();
+	PaletteColors.clear();
+	PaletteCache.clear();
+	auto jPalette = JsonStyleParam.value("palette").toObject();
+	if (jPalette.isEmpty())
+	{
+		return;
+	}
+
+	PaletteBaseColor = jPalette.value("base_color").toString();
+	parsePaletteColorGroup(jPalette, QPalette::Active);
+	parsePaletteColorGroup(jPalette, QPalette::Disabled);
+	parsePaletteColorGroup(jPalette, QPalette::Inactive);
+}
+
+
+//============================================================================
+void QtAdvancedStylesheetPrivate::parsePaletteColorGroup(QJsonObject& jPalette, QPalette::ColorGroup ColorGroup)
+{
+	auto jColorGroup = jPalette.value(colorGroupString(ColorGroup)).toObject();
+	if (jColorGroup.isEmpty())
+	{
+		return;
+	}
+
+	for (auto itc = jColorGroup.constBegin(); itc != jColorGroup.constEnd(); ++itc)
+	{
+		auto ColorRole = colorRoleFromString(itc.key());
+		if (QPalette::NoRole == ColorRole)
+		{
+			continue;
+		}
+
+		this->PaletteColors.append({ColorGroup, ColorRole, itc.value().toString()});
+		if (ColorGroup != QPalette::Active)
+		{
+			continue;
+		}
+	}
+}
+
+
+//============================================================================
+void QtAdvancedStylesheetPrivate::markChangedVariables(
+	const QMap<QString, QString>& Old, const QMap<QString, QString>& New)
+{
+	for (auto itc = Old.constBegin(); itc != Old.constEnd(); ++itc)
+	{
+		auto it = New.constFind(itc.key());
+		if (it == New.constEnd() || it.value() != itc.value())
+		{
+			DirtyVariables.insert(itc.key());
+		}
+	}
+
+	for (auto itc = New.constBegin(); itc != New.constEnd(); ++itc)
+	{
+		if (!Old.contains(itc.key()))
+		{
+			DirtyVariables.insert(itc.key());
+		}
+	}
+}
+
+
+//============================================================================
+int QtAdvancedStylesheetPrivate::dirtyUpdateStages() const
+{
+	if (StyleDirty)
+	{
+		return PaletteStage | ResourcesStage | IconsStage | StylesheetStage;
+	}
+
+	int Stages = 0;
+	if (OutputDirty)
+	{
+		Stages |= ResourcesStage | StylesheetStage;
+	}
+
+	if (DirtyVariables.isEmpty())
+	{
+		return Stages;
+	}
+
+	// The template may use any variable
+	Stages |= StylesheetStage;
+
+	if (paletteVariables().intersects(DirtyVariables))
+	{
+		Stages |= PaletteStage;
+	}
+
+	// In shared output cache mode, each variable change changes the output
+	// folder
+	QSet<QString> ResourceVariables;
+	collectReferencedVariables(JsonStyleParam.value("resources").toObject(), ResourceVariables);
+	if (SharedOutputCache || ResourceVariables.intersects(DirtyVariables))
+	{
+		Stages |= ResourcesStage;
+	}
+
+	if (iconVariables().intersects(DirtyVariables))
+	{
+		Stages |= IconsStage;
+	}
+
+	return Stages;
+}
+
+
+//============================================================================
+QSet<QString> QtAdvancedStylesheetPrivate::paletteVariables() const
+{
+	QSet<QString> Variables;
+	if (!PaletteBaseColor.isEmpty())
+	{
+		Variables.insert(PaletteBaseColor);
+	}
+	for (const auto& Entry : PaletteColors)
+	{
+		Variables.insert(Entry.ColorVariable);
+	}
+	return Variables;
+}
+
+
+//============================================================================
+QSet<QString> QtAdvancedStylesheetPrivate::iconVariables() const
+{
+	QSet<QString> Variables;
+	for (auto Mode : {QIcon::Normal, QIcon::Disabled, QIcon::Selected})
+	{
+		collectReferencedVariables(JsonStyleParam.value(iconColorsJsonKey(Mode)).toObject(),
+			Variables);
+	}
+	return Variables;
+}
+
+
+//============================================================================
+void QtAdvancedStylesheetPrivate::applyLivePreviewFrame()
+{
+	if (LivePreviewPending.isEmpty())
+	{
+		return;
+	}
+
+	QSet<QString> Changed;
+	for (auto itc = LivePreviewPending.constBegin(); itc != LivePreviewPending.constEnd(); ++itc)
+	{
+		_this->setThemeVariableValue(itc.key(), itc.value());
+		Changed.insert(itc.key());
+	}
+	LivePreviewPending.clear();
+	LivePreviewStylesheetDirty = true;
+
+	// The palette and the icon colors are cheap to update compared to the
+	// stylesheet - the stylesheet is updated when the user pauses
+	if (paletteVariables().intersects(Changed))
+	{
+		_this->updateApplicationPaletteColors();
+	}
+
+	if (iconVariables().intersects(Changed))
+	{
+		IconColorReplaceLists.clear();
+		CSVGIconEngine::updateAllIcons();
+		if (qobject_cast<QApplication*>(QCoreApplication::instance()))
+		{
+			for (auto Widget : QApplication::topLevelWidgets())
+			{
+				Widget->update();
+			}
+		}
+	}
+}
+
+
+//============================================================================
+void QtAdvancedStylesheetPrivate::applyLivePreviewPause()
+{
+	applyLivePreviewFrame();
+	if (!LivePreviewStylesheetDirty)
+	{
+		return;
+	}
+
+	LivePreviewStylesheetDirty = false;
+	bool StylesheetUpdated;
+	if (runUpdateStages(StylesheetUpdated) && StylesheetUpdated)
+	{
+		emit _this->stylesheetChanged();
+	}
+}
+
+
+//============================================================================
+void QtAdvancedStylesheetPrivate::stopLivePreview()
+{
+	LivePreviewFrameTimer->stop();
+	LivePreviewPauseTimer->stop();
+	LivePreview = false;
+	LivePreviewStylesheetDirty = false;
+	LivePreviewSavedVariables.clear();
+	LivePreviewSavedColors.clear();
+}
+
+
+//============================================================================
+QString QtAdvancedStylesheetPrivate::paletteCacheKey(const QPalette& BasePalette) const
+{
+	// If the style defines no valid base color, the palette is derived from
+	// the current application palette
+	const QColor BaseColor(ThemeColors.value(PaletteBaseColor));
+	QString Key = (PaletteBaseColor.isEmpty() || !BaseColor.isValid())
+		? QString::number(BasePalette.cacheKey())
+		: BaseColor.name(QColor::HexArgb);
+	for (const auto& Entry : PaletteColors)
+	{
+		Key += ';' + ThemeColors.value(Entry.ColorVariable);
+	}
+	return Key;
+}
+
+
+//============================================================================
+QVector<QPalette::ColorRole> QtAdvancedStylesheetPrivate::changedColorRoles(
+	const QPalette& From, const QPalette& To)
+{
+	static const QPalette::ColorGroup ColorGroups[] = {QPalette::Active,
+		QPalette::Disabled, QPalette::Inactive};
+
+	QVector<QPalette::ColorRole> ColorRoles;
+	for (int i = 0; i < QPalette::NColorRoles; ++i)
+	{
+		auto Role = static_cast<QPalette::ColorRole>(i);
+		if (Role == QPalette::NoRole)
+		{
+			continue;
+		}
+
+		for (auto Group : ColorGroups)
+		{
+			if (From.brush(Group, Role) != To.brush(Group, Role))
+			{
+				ColorRoles.append(Role);
+				break;
+			}
+		}
+	}
+	return ColorRoles;
+}
+
+
+//============================================================================
+void QtAdvancedStylesheetPrivate::replaceColor(QByteArray& Content,
+	const QString& TemplateColor, const QString& ThemeColor) const
+{
+	Content.replace(TemplateColor.toLatin1(), ThemeColor.toLatin1());
+}
+
+
+//============================================================================
+void QtAdvancedStylesheetPrivate::publishRecolorData()
+{
+	QHash<QString, tColorReplaceList> Variants;
+	auto jresources = JsonStyleParam.value("resources").toObject();
+	for (auto itc = jresources.constBegin(); itc != jresources.constEnd(); ++itc)
+	{
+		Variants.insert(itc.key(), parseColorReplaceList(itc.value().toObject()));
+	}
+
+	QHash<QString, QByteArray> Templates;
+	if (Compiled)
+	{
+		auto CompiledTemplates = resourceTemplates();
+		optimizeResourceTemplates(CompiledTemplates);
+		for (const auto& Template : CompiledTemplates)
+		{
+			Templates.insert(Template.first, Template.second);
+		}
+	}
+
+	QMutexLocker Locker(&RecolorMutex);
+	RecolorResourceDir = _this->path(QtAdvancedStylesheet::ResourceTemplatesLocation);
+	RecolorTemplates = Templates;
+	RecolorOutputDir = _this->currentStyleOutputPath();
+	RecolorLazy = lazyResources() || deferResources();
+	RecolorRasterScales = RasterScales;
+	RecolorRasterSize = RasterSize;
+	RecolorOptimizeSvg = SvgOptimization;
+	RecolorVariants = Variants;
+	RecolorIconColors = iconColorReplaceList();
+	RecolorCache.clear();
+	RecolorGeneration = ThemeGeneration.fetchAndAddOrdered(1) + 1;
+}
+
+
+//============================================================================
+void QtAdvancedStylesheetPrivate::publishThemeSnapshot()
+{
+	// Only the GUI thread publishes snapshots, so the generation can be
+	// incremented without a compare and swap
+	tThemeSnapshotPtr NewSnapshot(new CThemeSnapshot(
+		SnapshotGeneration.loadAcquire() + 1, CurrentStyle, CurrentTheme,
+		IsDarkTheme, ThemeVariables, ThemeColors, _this->generateThemePalette(),
+		iconColorReplaceList()));
+
+	std::atomic_store(&Snapshot, NewSnapshot);
+	SnapshotGeneration.storeRelease(NewSnapshot->generation());
+}
+
+
+//============================================================================
+void QtAdvancedStylesheetPrivate::updateVariableIdTables() const
+{
+	VariableIdValues.resize(VariableIds.size());
+	VariableIdColors.resize(VariableIds.size());
+	for (int i = 0; i < VariableIds.size(); ++i)
+	{
+		VariableIdValues[i] = ThemeVariables.value(VariableIds[i]);
+		const auto ColorString = ThemeColors.value(VariableIds[i]);
+		VariableIdColors[i] = ColorString.isEmpty() ? QColor() : QColor(ColorString);
+	}
+	VariableIdTablesDirty = false;
+}
+
+
+//============================================================================
+void QtAdvancedStylesheetPrivate::enqueueDeferredWork(const QString& Key,
+	int Priority, std::function<bool()> Work)
+{
+	for (int i = 0; i < DeferredTasks.size(); ++i)
+	{
+		if (DeferredTasks[i].Key == Key)
+		{
+			DeferredTasks.remove(i);
+			break;
+		}
+	}
+
+	int Index = 0;
+	while (Index < DeferredTasks.size() && DeferredTasks[Index].Priority <= Priority)
+	{
+		++Index;
+	}
+	DeferredTask Task{++DeferredTaskCounter, Key, Priority, std::move(Work)};
+	DeferredTasks.insert(Index, Task);
+
+	// A zero timer fires as soon as the event loop has processed all
+	// pending events
+	if (!DeferredWorkTimer)
+	{
+		DeferredWorkTimer = new QTimer(_this);
+		DeferredWorkTimer->setInterval(0);
+		QObject::connect(DeferredWorkTimer, &QTimer::timeout, _this, [this]()
+		{
+			if (runDeferredWork(qint64(DeferredWorkTimeSliceMs) * 1000000))
+			{
+				DeferredWorkTimer->stop();
+			}
+		});
+	}
+	DeferredWorkTimer->start();
+}
+
+
+//============================================================================
+bool QtAdvancedStylesheetPrivate::runDeferredWork(qint64 TimeSliceNs)
+{
+	QElapsedTimer Timer;
+	Timer.start();
+	while (!DeferredTasks.isEmpty())
+	{
+		if (TimeSliceNs >= 0 && Timer.nsecsElapsed() >= TimeSliceNs)
+		{
+			return false;
+		}
+
+		// The work may enqueue new tasks - so we work on a copy
+		const auto Task = DeferredTasks.first();
+		if (!Task.Work())
+		{
+			continue;
+		}
+		for (int i = 0; i < DeferredTasks.size(); ++i)
+		{
+			if (DeferredTasks[i].Id == Task.Id)
+			{
+				DeferredTasks.remove(i);
+				break;
+			}
+		}
+	}
+	return true;
+}
+
+
+//============================================================================
+void QtAdvancedStylesheetPrivate::cancelDeferredWork()
+{
+	DeferredTasks.clear();
+	if (DeferredWorkTimer)
+	{
+		DeferredWorkTimer->stop();
+	}
+}
+
+
+//============================================================================
+void QtAdvancedStylesheetPrivate::deferResourceGeneration()
+{
+	QSharedPointer<QStringList> Resources(new QStringList());
+	const auto FileNames = resourceTemplateNames();
+	auto jresources = JsonStyleParam.value("resources").toObject();
+	for (auto itc = jresources.constBegin(); itc != jresources.constEnd(); ++itc)
+	{
+		for (const auto& FileName : FileNames)
+		{
+			Resources->append(itc.key() + "/" + FileName);
+		}
+	}
+
+	// generateResource() skips the resources that have already been
+	// generated for the current theme
+	enqueueDeferredWork("resources", NormalPriority, [this, Resources]()
+	{
+		if (!Resources->isEmpty())
+		{
+			_this->generateResource(Resources->takeLast());
+		}
+		return Resources->isEmpty();
+	});
+}
+
+
+//============================================================================
+QByteArray QtAdvancedStylesheetPrivate::recoloredSvg(const QString& CacheKey,
+	const QString& Filename, const QByteArray& Template,
+	const tColorReplaceList& ColorReplaceList, int Generation) const
+{
+	// File I/O and color replacement are done without holding the lock
+	auto Content = Template;
+	if (Content.isNull())
+	{
+		QFile SvgFile(Filename);
+		if (!SvgFile.open(QIODevice::ReadOnly))
+		{
+			return QByteArray();
+		}
+		Content = SvgFile.readAll();
+	}
+	for (const auto& Replace : ColorReplaceList)
+	{
+		Content.replace(Replace.first.toLatin1(), Replace.second.toLatin1());
+	}
+
+	QMutexLocker Locker(&RecolorMutex);
+	if (Generation == RecolorGeneration)
+	{
+		RecolorCache.insert(CacheKey, Content);
+	}
+	return Content;
+}
+
+
+//============================================================================
+tColorReplaceList QtAdvancedStylesheetPrivate::parseColorReplaceList(const QJsonObject& JsonObject) const
+{
+	// Fill the color replace list with the values read from style json file
+	tColorReplaceList ColorReplaceList;
+	for (auto it = JsonObject.constBegin(); it != JsonObject.constEnd(); ++it)
+	{
+		auto TemplateColor = it.key();
+		auto ThemeColor = it.value().toString();
+		// If the color starts with an hashtag, then we have a real color value
+		// If it does not start with # then it is a theme variable
+		if (!ThemeColor.startsWith('#'))
+		{
+			ThemeColor = _this->themeVariableValue(ThemeColor);
+		}
+		ColorReplaceList.append({TemplateColor, ThemeColor});
+	}
+
+	return ColorReplaceList;
+}
+
+
+//============================================================================
+bool QtAdvancedStylesheetPrivate::generateResourcesFor(const QString& SubDir,
+	const QJsonObject& JsonObject, const tResourceTemplates& Templates)
+{
+	const QString OutputDir = _this->currentStyleOutputPath() + "/" + SubDir;
+	if (!QDir().mkpath(OutputDir))
+	{
+		setError(QtAdvancedStylesheet::ResourceGeneratorError, "Error "
+			"creating resource output folder: " + OutputDir);
+		return false;
+	}
+
+	auto ColorReplaceList = parseColorReplaceList(JsonObject);
+
+	// Now loop through all resources svg files and replace the colors
+	QVector<RasterJob> RasterJobs;
+	for (const auto& Template : Templates)
+	{
+		auto Content = Template.second;
+		_this->replaceSvgColors(Content, ColorReplaceList);
+		QString OutputFilename = OutputDir + "/" + Template.first;
+		QString ErrorString;
+		if (!writeFileAtomic(OutputFilename, Content, &ErrorString))
+		{
+			setError(QtAdvancedStylesheet::ResourceGeneratorError, "Error "
+				"writing resource " + OutputFilename + ": " + ErrorString);
+			return false;
+		}
+		if (!RasterScales.isEmpty())
+		{
+			RasterJobs.append({OutputFilename, Content, QString()});
+		}
+	}
+
+	// Rendering and PNG encoding are expensive - so the PNG files are
+	// rendered in parallel
+	QtConcurrent::blockingMap(RasterJobs, [this](RasterJob& Job)
+	{
+		if (!writeRasterResources(Job.SvgFilename, Job.Content, RasterScales,
+			RasterSize, &Job.ErrorString) && Job.ErrorString.isEmpty())
+		{
+			Job.ErrorString = "Unknown error";
+		}
+	});
+	for (const auto& Job : RasterJobs)
+	{
+		if (!Job.ErrorString.isEmpty())
+		{
+			setError(QtAdvancedStylesheet::ResourceGeneratorError, "Error "
+				"writing PNG resources for " + Job.SvgFilename + ": " + Job.ErrorString);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+//============================================================================
+const tColorReplaceList& QtAdvancedStylesheetPrivate::iconColorReplaceList(QIcon::Mode Mode) const
+{
+	if (Mode == QIcon::Active)
+	{
+		Mode = QIcon::Normal;
+	}
+
+	auto it = IconColorReplaceLists.find(Mode);
+	if (it != IconColorReplaceLists.end())
+	{
+		return it.value();
+	}
+
+	auto jicon_colors = JsonStyleParam.value(iconColorsJsonKey(Mode)).toObject();
+	return IconColorReplaceLists.insert(Mode, parseColorReplaceList(jicon_colors)).value();
+}
+
+
+//============================================================================
+void CSVGIconEngine::update()
+{
+	auto d = QtAdvancedStylesheetPrivate::get(m_AdvancedStyleheet);
+	m_SvgContent = m_SvgTemplate;
+	m_AdvancedStyleheet->replaceSvgColors(m_SvgContent);
+
+	// The mode specific lists may be empty and replaceSvgColors() would use
+	// the normal list for an empty list
+	m_DisabledSvgContent.clear();
+	const auto& DisabledColors = d->iconColorReplaceList(QIcon::Disabled);
+	if (!DisabledColors.isEmpty())
+	{
+		m_DisabledSvgContent = m_SvgTemplate;
+		m_AdvancedStyleheet->replaceSvgColors(m_DisabledSvgContent, DisabledColors);
+	}
+
+	m_SelectedSvgContent.clear();
+	const auto& SelectedColors = d->iconColorReplaceList(QIcon::Selected);
+	if (!SelectedColors.isEmpty())
+	{
+		m_SelectedSvgContent = m_SvgTemplate;
+		m_AdvancedStyleheet->replaceSvgColors(m_SelectedSvgContent, SelectedColors);
+	}
+	m_Pixmaps.clear();
+	m_Pictures.clear();
+	m_Outdated = false;
+}
+
+
+//============================================================================
+QPixmap CSVGIconEngine::sharedPixmap(const QSize& PixelSize, QIcon::Mode Mode, qreal Scale)
+{
+	auto Cache = QtAdvancedStylesheetPrivate::get(m_AdvancedStyleheet)->SharedIconCache.data();
+	if (!Cache)
+	{
+		return renderPixmap(PixelSize, Mode);
+	}
+
+	// The recolored SVG content contains the theme colors, so the key is
+	// the same in all processes that use the same theme
+	const auto Key = CSharedIconCache::entryKey(svgContent(Mode), PixelSize, Scale, Mode);
+	auto Image = Cache->find(Key);
+	if (Image.isNull())
+	{
+		auto Pixmap = renderPixmap(PixelSize, Mode);
+		Image = Cache->insert(Key, Pixmap.toImage());
+		if (Image.isNull())
+		{
+			return Pixmap;
+		}
+	}
+
+	return QPixmap::fromImage(std::move(Image), Qt::NoFormatConversion);
+}
+
+
+
+//============================================================================
+void CSVGIconEngine::addMemoryUsage(const QtAdvancedStylesheet* Stylesheet,
+	QtAdvancedStylesheet::MemoryUsage& Usage)
+{
+	// Copies of an icon share their data implicitly. We count shared data
+	// once and report templates that duplicate the content of another
+	// template without sharing it
+	QSet<const char*> CountedData;
+	QSet<qint64> CountedPixmaps;
+	QHash<QByteArray, const char*> TemplateData;
+	QSet<const char*> DuplicateData;
+	for (auto Engine : *IconEngineInstances)
+	{
+		if (Engine->m_AdvancedStyleheet != Stylesheet)
+		{
+			continue;
+		}
+
+		Usage.IconEngineCount++;
+		const auto& Template = Engine->m_SvgTemplate;
+		Usage.IconTemplateBytes += uncountedBytes(Template, CountedData);
+		auto it = TemplateData.constFind(Template);
+		if (it == TemplateData.constEnd())
+		{
+			TemplateData.insert(Template, Template.constData());
+		}
+		else if (it.value() != Template.constData()
+		      && !DuplicateData.contains(Template.constData()))
+		{
+			DuplicateData.insert(Template.constData());
+			Usage.DuplicateIconTemplates++;
+			Usage.DuplicateIconTemplateBytes += Template.capacity();
+		}
+
+		Usage.IconContentBytes += uncountedBytes(Engine->m_SvgContent, CountedData)
+			+ uncountedBytes(Engine->m_DisabledSvgContent, CountedData)
+			+ uncountedBytes(Engine->m_SelectedSvgContent, CountedData);
+		for (const auto& Picture : Engine->m_Pictures)
+		{
+			Usage.IconContentBytes += Picture.size();
+		}
+		for (const auto& Pixmap : Engine->m_Pixmaps)
+		{
+			if (CountedPixmaps.contains(Pixmap.cacheKey()))
+			{
+				continue;
+			}
+			CountedPixmaps.insert(Pixmap.cacheKey());
+			Usage.IconPixmapCount++;
+			Usage.IconPixmapBytes += qint64(Pixmap.width()) * Pixmap.height()
+				* Pixmap.depth() / 8;
+		}
+	}
+	Usage.UniqueIconTemplates = TemplateData.size();
+}
+
+
+//============================================================================
+void QtAdvancedStylesheet::replaceSvgColors(QByteArray& SvgContent,
+	const tColorReplaceList& ColorReplaceList)
+{
+	const tColorReplaceList& ReplaceList = ColorReplaceList.isEmpty() ?
+		d->iconColorReplaceList() : ColorReplaceList;
+	for (const auto& Replace : ReplaceList)
+	{
+		d->replaceColor(SvgContent, Replace.first, Replace.second);
+	}
+}
+
+
+//============================================================================
+QIcon QtAdvancedStylesheet::loadThemeAwareSvgIcon(const QString& Filename)
+{
+	QFile SvgFile(Filename);
+	SvgFile.open(QIODevice::ReadOnly);
+	auto Content = SvgFile.readAll();
+	return QIcon(new CSVGIconEngine(Content, this));
+}
+
+
+/**
+ * Private data class of CThemeAwareIconSet class (pimpl)
+ */
+struct ThemeAwareIconSetPrivate
+{
+	QPointer<QtAdvancedStylesheet> Stylesheet;
+	int Generation = 0;///< theme generation the icons have been recolored for
+	QVector<PreloadedIcon> Icons;///< written by the worker threads
+	QHash<QString, int> IconIndexes;
+	QHash<QString, QIcon> CreatedIcons;
+	QFuture<void> Future;
+
+	/**
+	 * Stops the loading, because the worker threads write into Icons
+	 */
+	~ThemeAwareIconSetPrivate()
+	{
+		Future.cancel();
+		Future.waitForFinished();
+	}
+};
+
+
+//============================================================================
+CThemeAwareIconSet::CThemeAwareIconSet() :
+	d(new ThemeAwareIconSetPrivate())
+{
+
+}
+
+
+//============================================================================
+bool CThemeAwareIconSet::isFinished() const
+{
+	return d->Future.isFinished();
+}
+
+
+//============================================================================
+void CThemeAwareIconSet::waitForFinished() const
+{
+	d->Future.waitForFinished();
+}
+
+
+//============================================================================
+QStringList CThemeAwareIconSet::fileNames() const
+{
+	QStringList Result;
+	for (const auto& Icon : d->Icons)
+	{
+		Result.append(Icon.Filename);
+	}
+	return Result;
+}
+
+
+//============================================================================
+QStringList CThemeAwareIconSet::failedFileNames() const
+{
+	d->Future.waitForFinished();
+	QStringList Result;
+	for (const auto& Icon : d->Icons)
+	{
+		if (!Icon.ErrorString.isEmpty())
+		{
+			Result.append(Icon.Filename);
+		}
+	}
+	return Result;
+}
+
+
+//============================================================================
+QIcon CThemeAwareIconSet::icon(const QString& Filename) const
+{
+	const auto FilePath = QFileInfo(Filename).absoluteFilePath();
+	auto it = d->CreatedIcons.constFind(FilePath);
+	if (it != d->CreatedIcons.constEnd())
+	{
+		return it.value();
+	}
+
+	const int Index = d->IconIndexes.value(FilePath, -1);
+	if (Index < 0 || !d->Stylesheet)
+	{
+		return QIcon();
+	}
+
+	d->Future.waitForFinished();
+	auto& Preloaded = d->Icons[Index];
+	if (!Preloaded.ErrorString.isEmpty())
+	{
+		return QIcon();
+	}
+	auto Engine = new CSVGIconEngine(Preloaded, d->Stylesheet);
+	// The theme may have changed while the icons have been loaded
+	if (d->Generation != d->Stylesheet->themeGeneration())
+	{
+		Engine->update();
+	}
+	Preloaded.Images.clear();
+	QIcon Icon(Engine);
+	d->CreatedIcons.insert(FilePath, Icon);
+	return Icon;
+}
+
+
+/**
+ * Returns the given SVG data with replaced colors
+ */
+static QByteArray recoloredSvgData(QByteArray Content, const tColorReplaceList& ColorReplaceList)
+{
+	for (const auto& Replace : ColorReplaceList)
+	{
+		Content.replace(Replace.first.toLatin1(), Replace.second.toLatin1());
+	}
+	return Content;
+}
+
+
+//============================================================================
+CThemeAwareIconSet QtAdvancedStylesheet::preloadThemeAwareSvgIcons(
+	const QStringList& Filenames, const QList<QSize>& PixmapSizes)
+{
+	CThemeAwareIconSet IconSet;
+	auto IconSetData = IconSet.d;
+	IconSetData->Stylesheet = this;
+	IconSetData->Generation = themeGeneration();
+	for (const auto& Filename : Filenames)
+	{
+		const auto FilePath = QFileInfo(Filename).absoluteFilePath();
+		if (IconSetData->IconIndexes.contains(FilePath))
+		{
+			continue;
+		}
+		IconSetData->IconIndexes.insert(FilePath, IconSetData->Icons.size());
+		PreloadedIcon Icon;
+		Icon.Filename = FilePath;
+		IconSetData->Icons.append(Icon);
+	}
+
+	// The worker threads only use copies of the color replace lists. Like
+	// CSVGIconEngine::update(), the mode specific contents are only created
+	// if the style defines colors for the mode.
+	const auto NormalColors = d->iconColorReplaceList(QIcon::Normal);
+	const auto DisabledColors = d->iconColorReplaceList(QIcon::Disabled);
+	const auto SelectedColors = d->iconColorReplaceList(QIcon::Selected);
+	auto Application = qobject_cast<QGuiApplication*>(QCoreApplication::instance());
+	const qreal Scale = Application ? Application->devicePixelRatio() : 1.0;
+	IconSetData->Future = QtConcurrent::map(IconSetData->Icons,
+		[NormalColors, DisabledColors, SelectedColors, PixmapSizes, Scale](PreloadedIcon& Icon)
+	{
+		QFile SvgFile(Icon.Filename);
+		if (!SvgFile.open(QIODevice::ReadOnly))
+		{
+			Icon.ErrorString = SvgFile.errorString();
+			return;
+		}
+		Icon.SvgTemplate = SvgFile.readAll();
+		Icon.SvgContent = recoloredSvgData(Icon.SvgTemplate, NormalColors);
+		if (!DisabledColors.isEmpty())
+		{
+			Icon.DisabledSvgContent = recoloredSvgData(Icon.SvgTemplate, DisabledColors);
+		}
+		if (!SelectedColors.isEmpty())
+		{
+			Icon.SelectedSvgContent = recoloredSvgData(Icon.SvgTemplate, SelectedColors);
+		}
+		if (PixmapSizes.isEmpty() || Icon.SvgTemplate.isEmpty())
+		{
+			return;
+		}
+
+		// QPixmap may only be used in the GUI thread - so we render images
+		QSvgRenderer Renderer(Icon.SvgContent);
+		for (const auto& Size : PixmapSizes)
+		{
+			const QSize PixelSize = Size * Scale;
+			QImage Image(PixelSize, QImage::Format_ARGB32_Premultiplied);
+			Image.fill(Qt::transparent);
+			{
+				QPainter Painter(&Image);
+				Renderer.render(&Painter, QRect(QPoint(0, 0), PixelSize));
+			}
+			Image.setDevicePixelRatio(Scale);
+			Icon.Images.append({pixmapCacheKey(PixelSize, Scale, QIcon::Normal), Image});
+		}
+	});
+	return IconSet;
+}
+
+
+//============================================================================
+CThemeAwareIconSet QtAdvancedStylesheet::preloadThemeAwareSvgIconDir(
+	const QString& DirPath, const QList<QSize>& PixmapSizes)
+{
+	QStringList Filenames;
+	QDirIterator it(DirPath, {"*.svg"}, QDir::Files, QDirIterator::Subdirectories);
+	while (it.hasNext())
+	{
+		Filenames.append(it.next());
+	}
+	return preloadThemeAwareSvgIcons(Filenames, PixmapSizes);
+}
+
+
+//============================================================================
+QByteArray QtAdvancedStylesheet::resourceSvgData(const QString& ResourcePath) const
+{
+	const auto Path = ResourcePath.startsWith('/') ? ResourcePath.mid(1) : ResourcePath;
+	const auto Variant = Path.section('/', 0, 0);
+	const auto FileName = Path.section('/', 1);
+	if (FileName.isEmpty() || FileName.contains(".."))
+	{
+		return QByteArray();
+	}
+
+	QString Filename;
+	QByteArray Template;
+	tColorReplaceList ColorReplaceList;
+	int Generation;
+	bool OptimizeSvg;
+	{
+		QMutexLocker Locker(&d->RecolorMutex);
+		auto it = d->RecolorCache.constFind(Path);
+		if (it != d->RecolorCache.constEnd())
+		{
+			return it.value();
+		}
+
+		auto itv = d->RecolorVariants.constFind(Variant);
+		if (itv == d->RecolorVariants.constEnd())
+		{
+			return QByteArray();
+		}
+		// The resource templates of compiled styles are not on disk
+		if (!d->RecolorTemplates.isEmpty())
+		{
+			Template = d->RecolorTemplates.value(FileName);
+			if (Template.isNull())
+			{
+				return QByteArray();
+			}
+		}
+		ColorReplaceList = itv.value();
+		Filename = d->RecolorResourceDir + "/" + FileName;
+		Generation = d->RecolorGeneration;
+		OptimizeSvg = d->RecolorOptimizeSvg;
+	}
+
+	if (OptimizeSvg && Template.isNull())
+	{
+		QFile SvgFile(Filename);
+		if (!SvgFile.open(QIODevice::ReadOnly))
+		{
+			return QByteArray();
+		}
+		Template = CSvgOptimizer().optimize(SvgFile.readAll());
+	}
+
+	return d->recoloredSvg(Path, Filename, Template, ColorReplaceList, Generation);
+}
+
+
+//============================================================================
+QByteArray QtAdvancedStylesheet::themeAwareSvgData(const QString& Filename) const
+{
+	// File names are stored with a prefix to keep them apart from resources
+	const QString CacheKey = "file:" + Filename;
+	tColorReplaceList ColorReplaceList;
+	int Generation;
+	{
+		QMutexLocker Locker(&d->RecolorMutex);
+		auto it = d->RecolorCache.constFind(CacheKey);
+		if (it != d->RecolorCache.constEnd())
+		{
+			return it.value();
+		}
+		ColorReplaceList = d->RecolorIconColors;
+		Generation = d->RecolorGeneration;
+	}
+
+	return d->recoloredSvg(CacheKey, Filename, QByteArray(), ColorReplaceList,
+		Generation);
+}
+
+
+//============================================================================
+bool QtAdvancedStylesheet::isResourceVariant(const QString& Variant) const
+{
+	QMutexLocker Locker(&d->RecolorMutex);
+	return d->RecolorVariants.contains(Variant);
+}
+
+
+//============================================================================
+QString QtAdvancedStylesheet::generateResource(const QString& ResourcePath)
+{
+	const auto Path = ResourcePath.startsWith('/') ? ResourcePath.mid(1) : ResourcePath;
+	const auto SvgPath = svgResourcePath(Path);
+	QString OutputFilename;
+	QString SvgOutputFilename;
+	QVector<qreal> RasterScales;
+	QSize RasterSize;
+	int Generation;
+	{
+		QMutexLocker Locker(&d->RecolorMutex);
+		if (d->RecolorOutputDir.isEmpty() || !d->RecolorVariants.contains(Path.section('/', 0, 0)))
+		{
+			return QString();
+		}
+
+		// PNG resources only exist, if raster output is enabled
+		if (SvgPath != Path && d->RecolorRasterScales.isEmpty())
+		{
+			return QString();
+		}
+		OutputFilename = d->RecolorOutputDir + "/" + Path;
+		SvgOutputFilename = d->RecolorOutputDir + "/" + SvgPath;
+		if (!d->RecolorLazy || d->GeneratedResources.contains(SvgPath))
+		{
+			return OutputFilename;
+		}
+		RasterScales = d->RecolorRasterScales;
+		RasterSize = d->RecolorRasterSize;
+		Generation = d->RecolorGeneration;
+	}
+
+	auto Content = resourceSvgData(SvgPath);
+	if (Content.isEmpty())
+	{
+		return QString();
+	}
+	QDir().mkpath(QFileInfo(SvgOutputFilename).absolutePath());
+	if (!d->writeFileAtomic(SvgOutputFilename, Content))
+	{
+		return QString();
+	}
+	if (!RasterScales.isEmpty()
+	 && !d->writeRasterResources(SvgOutputFilename, Content, RasterScales, RasterSize))
+	{
+		return QString();
+	}
+
+	// If the theme changed in the meantime, the file has the old colors and
+	// will be generated again on the next access
+	QMutexLocker Locker(&d->RecolorMutex);
+	if (Generation == d->RecolorGeneration)
+	{
+		d->GeneratedResources.insert(SvgPath);
+	}
+	return OutputFilename;
+}
+
+
+//============================================================================
+QVector<qreal> QtAdvancedStylesheet::rasterResourceScales() const
+{
+	return d->RasterScales;
+}
+
+
+//============================================================================
+void QtAdvancedStylesheet::setRasterResourceScales(const QVector<qreal>& Scales)
+{
+	// Qt resolves only integer @Nx suffixes
+	for (auto Scale : Scales)
+	{
+		if (Scale < 1 || !qFuzzyCompare(Scale, qreal(qRound(Scale))))
+		{
+			qWarning() << "QtAdvancedStylesheet: raster resource scale" << Scale
+				<< "must be a positive integer";
+			return;
+		}
+	}
+
+	if (d->RasterScales == Scales)
+	{
+		return;
+	}
+
+	d->RasterScales = Scales;
+	d->OutputDirty = true;
+}
+
+
+//============================================================================
+QSize QtAdvancedStylesheet::rasterResourceSize() const
+{
+	return d->RasterSize;
+}
+
+
+//============================================================================
+void QtAdvancedStylesheet::setRasterResourceSize(const QSize& Size)
+{
+	if (d->RasterSize == Size)
+	{
+		return;
+	}
+
+	d->RasterSize = Size;
+	d->OutputDirty = true;
+}
+
+
+//============================================================================
+bool QtAdvancedStylesheet::isSvgOptimizationEnabled() const
+{
+	return d->SvgOptimization;
+}
+
+
+//============================================================================
+void QtAdvancedStylesheet::setSvgOptimizationEnabled(bool Enabled)
 {
+	if (d->SvgOptimization == Enabled)
+	{
+		return;
+	}
 
+	d->SvgOptimization = Enabled;
+	d->OutputDirty = true;
 }
 
 
 //============================================================================
-void QtAdvancedStylesheetPrivate::setError(QtAdvancedStylesheet::eError Error,
-	const QString& ErrorString)
+CSvgOptimizer::Statistics QtAdvancedStylesheet::svgOptimizationStatistics() const
 {
-	this->Error = Error;
-	this->ErrorString = ErrorString;
-	if (Error != QtAdvancedStylesheet::NoError)
+	return d->SvgOptimizationStatistics;
+}
+
+
+//============================================================================
+bool QtAdvancedStylesheet::isLazyResourceGenerationEnabled() const
+{
+	return d->LazyResourceGeneration;
+}
+
+
+//============================================================================
+void QtAdvancedStylesheet::setLazyResourceGenerationEnabled(bool Enabled)
+{
+	if (d->LazyResourceGeneration == Enabled)
 	{
-		qDebug() << "CAdvancedStylesheet Error: " << Error << " " << ErrorString;
+		return;
 	}
+
+	d->LazyResourceGeneration = Enabled;
+	d->OutputDirty = true;
 }
 
 
 //============================================================================
-QString QtAdvancedStylesheetPrivate::rgbaColor(const QString& RgbColor, float Opacity)
+QString QtAdvancedStylesheet::sharedIconCacheKey() const
 {
-	int Alpha = 255 * Opacity;
-	auto RgbaColor = RgbColor;
-	RgbaColor.insert(1, QString("%1").arg(Alpha, 2, 16, QChar('0')));
-	return RgbaColor;
+	return d->SharedIconCache ? d->SharedIconCache->key() : QString();
 }
 
 
 //============================================================================
-void QtAdvancedStylesheetPrivate::replaceStylesheetVariables(QString& Content)
+bool QtAdvancedStylesheet::setSharedIconCacheKey(const QString& Key, qint64 SizeBytes)
 {
-	static const int OpacityStrSize = QString("opacity(").size();
+	if (Key == sharedIconCacheKey())
+	{
+		return true;
+	}
 
-	QRegularExpression re("\\{\\{.*\\}\\}");
-	QRegularExpressionMatch match;
-	int index = 0;
-	while ((index = Content.indexOf(re, index, &match)) != -1)
+	d->SharedIconCache.reset();
+	if (Key.isEmpty())
 	{
-		QString ValueString;
-		QString MatchString = match.captured();
-		// Use only the value inside of the brackets {{ }} without the brackets
-                auto TemplateVariable = MatchString.mid(2, MatchString.size() - 4);
-		bool HasOpacity = TemplateVariable.endsWith(')');
+		return true;
+	}
 
-		if (HasOpacity)
-		{
-			auto Values = TemplateVariable.split("|");
-                        ValueString = _this->themeVariableValue(Values[0]);
-			auto OpacityStr = Values[1].mid(OpacityStrSize, Values[1].size() - OpacityStrSize - 1);
-			bool Ok;
-			auto Opacity = OpacityStr.toFloat(&Ok);
-			ValueString = rgbaColor(ValueString, Opacity);
-		}
-		else
+	auto Cache = SharedIconCaches->value(Key);
+	if (!Cache)
+	{
+		Cache.reset(new CSharedIconCache(Key, SizeBytes));
+		if (!Cache->isAttached())
 		{
-                        ValueString = _this->themeVariableValue(TemplateVariable);
+			d->setError(SharedIconCacheError, "Attaching shared icon cache " + Key
+				+ " failed: " + Cache->errorString());
+			return false;
 		}
+		SharedIconCaches->insert(Key, Cache);
+	}
+	d->SharedIconCache = Cache;
+	return true;
+}
+
+
+//============================================================================
+CSharedIconCache::Statistics QtAdvancedStylesheet::sharedIconCacheStatistics() const
+{
+	return d->SharedIconCache ? d->SharedIconCache->statistics() : CSharedIconCache::Statistics();
+}
 
-		Content.replace(index, MatchString.size(), ValueString);
-		index += ValueString.size();
+
+//============================================================================
+bool QtAdvancedStylesheet::isDeferredWorkEnabled() const
+{
+	return d->DeferredWork;
+}
+
+
+//============================================================================
+void QtAdvancedStylesheet::setDeferredWorkEnabled(bool Enabled)
+{
+	if (d->DeferredWork == Enabled)
+	{
+		return;
+	}
+
+	if (!Enabled)
+	{
+		flushDeferredWork();
 	}
+	d->DeferredWork = Enabled;
+	d->OutputDirty = true;
 }
 
 
 //============================================================================
-bool QtAdvancedStylesheetPrivate::generateStylesheet()
+bool QtAdvancedStylesheet::hasDeferredWork() const
+{
+	return !d->DeferredTasks.isEmpty();
+}
+
+
+//============================================================================
+void QtAdvancedStylesheet::flushDeferredWork()
 {
-	auto CssTemplateFileName = JsonStyleParam.value("css_template").toString();
-	if (CssTemplateFileName.isEmpty())
+	d->runDeferredWork(-1);
+	if (d->DeferredWorkTimer)
 	{
-		return false;
+		d->DeferredWorkTimer->stop();
 	}
+}
+
+
+//============================================================================
+QStringList QtAdvancedStylesheet::referencedResources() const
+{
+	QStringList Resources = (d->StylesheetReferences + d->TemplateReferences).values();
+	Resources.sort();
+	return Resources;
+}
 
-	QString TemplateFilePath = _this->currentStylePath() + "/" + CssTemplateFileName;
-	if (!QFile::exists(TemplateFilePath))
+
+//============================================================================
+QStringList QtAdvancedStylesheet::unreferencedResources() const
+{
+	const auto Referenced = d->StylesheetReferences + d->TemplateReferences;
+	const auto FileNames = d->resourceTemplateNames();
+	const auto Variants = d->JsonStyleParam.value("resources").toObject().keys();
+	QStringList Resources;
+	for (const auto& Variant : Variants)
 	{
-		setError(QtAdvancedStylesheet::CssTemplateError, "Stylesheet folder "
-			"does not contain the CSS template file " + CssTemplateFileName);
-		return false;
+		for (const auto& FileName : FileNames)
+		{
+			const auto Resource = Variant + "/" + FileName;
+			if (!Referenced.contains(Resource))
+			{
+				Resources.append(Resource);
+			}
+		}
 	}
+	return Resources;
+}
 
-	QFile TemplateFile(_this->currentStylePath() + "/" + CssTemplateFileName);
-	TemplateFile.open(QIODevice::ReadOnly);
-	QString Content(TemplateFile.readAll());
-	replaceStylesheetVariables(Content);
-	Stylesheet = Content;
-	exportInternalStylesheet(QFileInfo(TemplateFilePath).baseName() + ".css");
-	return true;
+
+//============================================================================
+int QtAdvancedStylesheet::themeGeneration() const
+{
+	return d->ThemeGeneration.loadAcquire();
 }
 
 
 //============================================================================
-bool QtAdvancedStylesheetPrivate::exportInternalStylesheet(const QString& Filename)
+QtAdvancedStylesheet::MemoryUsage QtAdvancedStylesheet::memoryUsage() const
 {
-	return storeStylesheet(this->Stylesheet, Filename);
+	MemoryUsage Usage;
+	Usage.StylesheetBytes = d->StylesheetUtf8.capacity();
+	// QJsonObject does not expose its internal size - the compact JSON
+	// size is an estimate
+	Usage.StyleParameterBytes = QJsonDocument(d->JsonStyleParam).toJson(
+		QJsonDocument::Compact).size();
+	Usage.VariableBytes = stringMapBytes(d->StyleVariables)
+		+ stringMapBytes(d->ThemeColors) + stringMapBytes(d->ThemeVariables);
+	CSVGIconEngine::addMemoryUsage(this, Usage);
+
+	// QPalette does not expose its internal size either - we estimate one
+	// brush per color group and role
+	Usage.PaletteCacheEntries = d->PaletteCache.size();
+	Usage.PaletteCacheBytes = Usage.PaletteCacheEntries
+		* qint64(QPalette::NColorGroups) * QPalette::NColorRoles * sizeof(QBrush);
+
+	QMutexLocker Locker(&d->RecolorMutex);
+	QSet<const char*> CountedData;
+	for (auto it = d->RecolorCache.constBegin(); it != d->RecolorCache.constEnd(); ++it)
+	{
+		Usage.RecolorCacheBytes += it.key().capacity() * qint64(sizeof(QChar))
+			+ uncountedBytes(it.value(), CountedData);
+	}
+	Usage.RecolorCacheEntries = d->RecolorCache.size();
+	// Templates of compiled styles reference the static data of the
+	// application and have no heap memory
+	for (const auto& Template : d->RecolorTemplates)
+	{
+		Usage.ResourceTemplateBytes += uncountedBytes(Template, CountedData);
+	}
+	return Usage;
 }
 
 
 //============================================================================
-bool QtAdvancedStylesheetPrivate::storeStylesheet(const QString& Stylesheet, const QString& Filename)
+QtAdvancedStylesheet::QtAdvancedStylesheet(QObject* parent) :
+	QObject(parent),
+	d(new QtAdvancedStylesheetPrivate(this))
 {
-	auto OutputPath = _this->currentStyleOutputPath();
-	QDir().mkpath(OutputPath);
-	QString OutputFilename = OutputPath + "/" + Filename;
-	QFile OutputFile(OutputFilename);
-	if (!OutputFile.open(QIODevice::WriteOnly))
+
+}
+
+
+//============================================================================
+QtAdvancedStylesheet::~QtAdvancedStylesheet()
+{
+	d->removeIconSearchPath();
+	d->assignIconUrlPrefix(QString());
+	delete d;
+}
+
+
+//============================================================================
+void QtAdvancedStylesheet::setStylesDirPath(const QString& DirPath)
+{
+	d->StylesDir = DirPath;
+	QDir Dir(d->StylesDir);
+	d->Styles = Dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+}
+
+
+//============================================================================
+QString QtAdvancedStylesheet::stylesDirPath() const
+{
+	return d->StylesDir;
+}
+
+
+//============================================================================
+bool QtAdvancedStylesheet::setCurrentStyle(const QString& Style)
+{
+	d->clearError();
+	d->Compiled = nullptr;
+	d->CurrentStyle = Style;
+	QDir Dir(path(ThemesLocation));
+	d->Themes = Dir.entryList({"*.xml"}, QDir::Files);
+	for (auto& Theme : d->Themes)
 	{
-		setError(QtAdvancedStylesheet::CssExportError, "Exporting stylesheet "
-			+ Filename + " caused error: " + OutputFile.errorString());
-		return false;
+		Theme.replace(".xml", "");
 	}
-	OutputFile.write(Stylesheet.toUtf8());
-	OutputFile.close();
+	auto Result = d->parseStyleJsonFile();
+	d->finishStyleChange();
+	return Result;
+}
+
+
+//============================================================================
+bool QtAdvancedStylesheet::setCurrentStyle(const CompiledStyle& Style)
+{
+	d->clearError();
+	d->Compiled = &Style;
+	d->CurrentStyle = QString::fromUtf8(Style.Style);
+	d->loadCompiledStyle();
+	d->finishStyleChange();
 	return true;
 }
 
 
 //============================================================================
-void QtAdvancedStylesheetPrivate::addFonts(QDir* Dir)
+bool QtAdvancedStylesheet::compileCurrentStyle(QIODevice& Device,
+	const QString& Identifier, bool EmbedFonts)
 {
-	// I dont't know, if this is the right way to detect, if there are any
-	// widgets. The call to QFontDatabase::addApplicationFont() will crash, if
-	// there are no widgets
-	if (qApp->allWidgets().isEmpty())
+	d->clearError();
+	if (d->JsonStyleParam.isEmpty() || d->Compiled)
 	{
-		return;
+		d->setError(StyleJsonError, "Compiling requires a style that has been "
+			"loaded from the styles dir");
+		return false;
 	}
 
-	if (!Dir)
+	if (!QRegularExpression("^[A-Za-z_][A-Za-z0-9_]*$").match(Identifier).hasMatch())
 	{
-		QDir FontsDir(_this->path(QtAdvancedStylesheet::FontsLocation));
-		addFonts(&FontsDir);
+		d->setError(StyleJsonError, "Invalid compiled style identifier " + Identifier);
+		return false;
 	}
-	else
+
+	QByteArray Out = "// Generated by acss_stylec from the style "
+		+ d->CurrentStyle.toUtf8() + " - do not edit\n"
+		"#include <CompiledStyle.h>\n\n"
+		"namespace\n{\nusing namespace acss;\n\n";
+
+	auto writeTable = [&Out](const char* Type, const QByteArray& Name,
+		const QByteArray& Rows)
 	{
-		auto Folders = Dir->entryList(QDir::Dirs | QDir::NoDotAndDotDot);
-		for (auto Folder : Folders)
+		if (!Rows.isEmpty())
 		{
-			Dir->cd(Folder);
-			addFonts(Dir);
-			Dir->cdUp();
+			Out += QByteArray("constexpr ") + Type + " " + Name + "[] = {\n" + Rows + "};\n\n";
 		}
+	};
 
-		auto FontFiles = Dir->entryList({"*.ttf"}, QDir::Files);
-		for (auto Font : FontFiles)
+	// Returns a string literal or for data that exceeds the string literal
+	// limits of some compilers, the name of a char array
+	int DataArrayCount = 0;
+	auto dataReference = [&](const QByteArray& Data)
+	{
+		if (Data.size() <= 60000)
 		{
-            QString FontFilename = Dir->absoluteFilePath(Font);
-			QFontDatabase::addApplicationFont(FontFilename);
+			return cStringLiteral(Data);
 		}
-	}
-}
 
+		auto Name = "Data" + QByteArray::number(DataArrayCount++);
+		Out += "constexpr char " + Name + "[] = {";
+		for (int i = 0; i < Data.size(); ++i)
+		{
+			Out += QByteArray((i % 16) ? " " : "\n\t") + "'\\"
+				+ QByteArray::number(uchar(Data[i]), 8).rightJustified(3, '0') + "',";
+		}
+		Out += "\n};\n\n";
+		return Name;
+	};
 
-//============================================================================
-bool QtAdvancedStylesheetPrivate::parseVariablesFromXml(
-	QXmlStreamReader& s, const QString& TagName, QMap<QString, QString>& Variables)
-{
-	while (s.readNextStartElement())
+	auto variableRows = [](const QMap<QString, QString>& Variables)
 	{
-		if (s.name() != TagName)
+		QByteArray Rows;
+		for (auto itc = Variables.constBegin(); itc != Variables.constEnd(); ++itc)
 		{
-			setError(QtAdvancedStylesheet::ThemeXmlError, "Malformed theme "
-                                "file - expected tag <" + TagName + "> instead of " + s.name().toString());
-			return false;
+			Rows += "\t{" + cStringLiteral(itc.key().toUtf8()) + ", "
+				+ cStringLiteral(itc.value().toUtf8()) + "},\n";
 		}
-		auto Name = s.attributes().value("name").toString();
-		if (Name.isEmpty())
+		return Rows;
+	};
+
+	auto colorReplaceRows = [](const QJsonObject& JsonObject)
+	{
+		QByteArray Rows;
+		for (auto itc = JsonObject.constBegin(); itc != JsonObject.constEnd(); ++itc)
 		{
-			setError(QtAdvancedStylesheet::ThemeXmlError, "Malformed theme file - "
-				"name attribute missing in <" + TagName + "> tag");
-			return false;
+			Rows += "\t{" + cStringLiteral(itc.key().toUtf8()) + ", "
+				+ cStringLiteral(itc.value().toString().toUtf8()) + "},\n";
 		}
+		return Rows;
+	};
 
-		auto Value = s.readElementText(QXmlStreamReader::SkipChildElements);
-		if (Value.isEmpty())
+	writeTable("CompiledVariable", "Variables", variableRows(d->StyleVariables));
+
+	// The themes are parsed with the same code that loads them at runtime
+	const auto ThemeVariables = d->ThemeVariables;
+	const auto ThemeColors = d->ThemeColors;
+	const bool IsDarkTheme = d->IsDarkTheme;
+	QByteArray ThemeRows;
+	for (int i = 0; i < d->Themes.size(); ++i)
+	{
+		if (!d->parseThemeFile(d->Themes[i] + ".xml"))
 		{
-			setError(QtAdvancedStylesheet::ThemeXmlError, "Malformed theme file - "
-				"text of <" + TagName + "> tag is empty");
+			break;
+		}
+		const auto Name = "Theme" + QByteArray::number(i) + "Colors";
+		writeTable("CompiledVariable", Name, variableRows(d->ThemeColors));
+		ThemeRows += "\t{" + cStringLiteral(d->Themes[i].toUtf8()) + ", "
+			+ (d->IsDarkTheme ? "true, " : "false, ")
+			+ cArrayReference(Name, d->ThemeColors.size()) + "},\n";
+	}
+	d->ThemeVariables = ThemeVariables;
+	d->ThemeColors = ThemeColors;
+	d->IsDarkTheme = IsDarkTheme;
+	d->VariableIdTablesDirty = true;
+	if (d->Error != NoError)
+	{
+		return false;
+	}
+	writeTable("CompiledTheme", "Themes", ThemeRows);
+
+	QByteArray PaletteRows;
+	for (const auto& Entry : d->PaletteColors)
+	{
+		PaletteRows += "\t{" + QByteArray::number(int(Entry.Group)) + ", "
+			+ QByteArray::number(int(Entry.Role)) + ", "
+			+ cStringLiteral(Entry.ColorVariable.toUtf8()) + "},\n";
+	}
+	writeTable("CompiledPaletteEntry", "PaletteEntries", PaletteRows);
+
+	const auto jresources = d->JsonStyleParam.value("resources").toObject();
+	QByteArray VariantRows;
+	int Index = 0;
+	for (auto itc = jresources.constBegin(); itc != jresources.constEnd(); ++itc, ++Index)
+	{
+		const auto jvariant = itc.value().toObject();
+		const auto Name = "Variant" + QByteArray::number(Index) + "Colors";
+		writeTable("CompiledColorReplace", Name, colorReplaceRows(jvariant));
+		VariantRows += "\t{" + cStringLiteral(itc.key().toUtf8()) + ", "
+			+ cArrayReference(Name, jvariant.size()) + "},\n";
+	}
+	writeTable("CompiledColorReplaceList", "ResourceVariants", VariantRows);
+
+	QByteArray IconColorsRows;
+	int IconColorsCount = 0;
+	for (auto Mode : {QIcon::Normal, QIcon::Disabled, QIcon::Selected})
+	{
+		const auto Key = iconColorsJsonKey(Mode);
+		if (!d->JsonStyleParam.contains(Key))
+		{
+			continue;
+		}
+		const auto jcolors = d->JsonStyleParam.value(Key).toObject();
+		const auto Name = "IconColors" + QByteArray::number(IconColorsCount++);
+		writeTable("CompiledColorReplace", Name, colorReplaceRows(jcolors));
+		IconColorsRows += "\t{" + cStringLiteral(Key.toUtf8()) + ", "
+			+ cArrayReference(Name, jcolors.size()) + "},\n";
+	}
+	writeTable("CompiledColorReplaceList", "IconColors", IconColorsRows);
+
+	const auto CssTemplateName = d->JsonStyleParam.value("css_template").toString();
+	QByteArray SegmentRows;
+	int SegmentCount = 0;
+	if (!CssTemplateName.isEmpty())
+	{
+		QFile TemplateFile(currentStylePath() + "/" + CssTemplateName);
+		if (!TemplateFile.open(QIODevice::ReadOnly))
+		{
+			d->setError(CssTemplateError, "Stylesheet folder does not contain "
+				"the CSS template file " + CssTemplateName);
 			return false;
 		}
 
-		Variables.insert(Name, Value);
+		parseStyleTemplate(TemplateFile.readAll(),
+			[&](const char* Text, int Size)
+			{
+				SegmentRows += "\t{" + dataReference(QByteArray(Text, Size)) + ", "
+					+ QByteArray::number(Size) + ", false, -1.0f},\n";
+				SegmentCount++;
+			},
+			[&](const QByteArray& Variable, float Opacity)
+			{
+				SegmentRows += "\t{" + cStringLiteral(Variable) + ", "
+					+ QByteArray::number(Variable.size()) + ", true, "
+					+ QByteArray::number(Opacity, 'f', 6) + "f},\n";
+				SegmentCount++;
+			});
+	}
+	writeTable("CompiledTemplateSegment", "TemplateSegments", SegmentRows);
+
+	const auto Templates = d->resourceTemplates();
+	QByteArray ResourceRows;
+	for (const auto& Template : Templates)
+	{
+		ResourceRows += "\t{" + cStringLiteral(Template.first.toUtf8()) + ", "
+			+ dataReference(Template.second) + ", "
+			+ QByteArray::number(Template.second.size()) + "},\n";
+	}
+	writeTable("CompiledResource", "Resources", ResourceRows);
+
+	// The font files are sorted to get reproducible sources
+	QStringList FontFiles;
+	QDirIterator it(path(FontsLocation), {"*.ttf"}, QDir::Files, QDirIterator::Subdirectories);
+	while (EmbedFonts && it.hasNext())
+	{
+		FontFiles.append(it.next());
+	}
+	FontFiles.sort();
+
+	QByteArray FontRows;
+	int FontCount = 0;
+	for (const auto& FontFilename : FontFiles)
+	{
+		QFile FontFile(FontFilename);
+		FontFile.open(QIODevice::ReadOnly);
+		const auto Data = FontFile.readAll();
+		const auto Name = "Font" + QByteArray::number(FontCount++);
+		Out += "constexpr unsigned char " + Name + "[] = {";
+		for (int i = 0; i < Data.size(); ++i)
+		{
+			Out += QByteArray((i % 20) ? " " : "\n\t") + QByteArray::number(uchar(Data[i])) + ",";
+		}
+		Out += "\n};\n\n";
+		FontRows += "\t{" + cStringLiteral(QFileInfo(FontFilename).fileName().toUtf8())
+			+ ", " + Name + ", "
+			+ QByteArray::number(Data.size()) + "},\n";
 	}
+	writeTable("CompiledFont", "Fonts", FontRows);
 
+	QByteArray IconSvg;
+	if (!d->IconFile.isEmpty())
+	{
+		QFile IconFile(currentStylePath() + "/" + d->IconFile);
+		if (IconFile.open(QIODevice::ReadOnly))
+		{
+			IconSvg = IconFile.readAll();
+		}
+	}
+	const auto IconSvgReference = IconSvg.isEmpty() ? QByteArray("nullptr")
+		: dataReference(IconSvg);
+
+	Out += "} // namespace\n\n"
+		"extern const acss::CompiledStyle " + Identifier.toUtf8() + " = {\n"
+		"\t" + cStringLiteral(d->CurrentStyle.toUtf8()) + ",\n"
+		"\t" + cStringLiteral(d->StyleName.toUtf8()) + ",\n"
+		"\t" + cStringLiteral(d->DefaultTheme.toUtf8()) + ",\n"
+		"\t" + cStringLiteral(CssTemplateName.toUtf8()) + ",\n"
+		"\t" + cStringLiteral(d->PaletteBaseColor.toUtf8()) + ",\n"
+		"\t" + IconSvgReference + ", " + QByteArray::number(IconSvg.size()) + ",\n"
+		"\t" + cArrayReference("Variables", d->StyleVariables.size()) + ",\n"
+		"\t" + cArrayReference("Themes", d->Themes.size()) + ",\n"
+		"\t" + cArrayReference("PaletteEntries", d->PaletteColors.size()) + ",\n"
+		"\t" + cArrayReference("TemplateSegments", SegmentCount) + ",\n"
+		"\t" + cArrayReference("ResourceVariants", jresources.size()) + ",\n"
+		"\t" + cArrayReference("IconColors", IconColorsCount) + ",\n"
+		"\t" + cArrayReference("Resources", Templates.size()) + ",\n"
+		"\t" + cArrayReference("Fonts", FontCount) + "\n"
+		"};\n";
+
+	if (Device.write(Out) != Out.size())
+	{
+		d->setError(CssExportError, "Writing compiled style caused error: "
+			+ Device.errorString());
+		return false;
+	}
 	return true;
 }
 
 
 //============================================================================
-bool QtAdvancedStylesheetPrivate::parseThemeFile(const QString& Theme)
+bool QtAdvancedStylesheet::isCompiledStyle() const
 {
-	QString ThemeFileName = _this->path(QtAdvancedStylesheet::ThemesLocation) + "/" + Theme;
-	QFile ThemeFile(ThemeFileName);
-	ThemeFile.open(QIODevice::ReadOnly);
-	QXmlStreamReader s(&ThemeFile);
-        s.readNextStartElement();
-        if (s.name() != QString("resources"))
-	{
-		setError(QtAdvancedStylesheet::ThemeXmlError, "Malformed theme file - "
-                        "expected tag <resources> instead of " + s.name().toString());
-		return false;
-	}
+	return d->Compiled != nullptr;
+}
 
-	IsDarkTheme = (s.attributes().value("dark").toInt() == 1);
-    QMap<QString, QString> ColorVariables;
-	parseVariablesFromXml(s, "color", ColorVariables);
-	this->ThemeVariables = this->StyleVariables;
-	insertIntoMap(this->ThemeVariables, ColorVariables);
-	this->ThemeColors = ColorVariables;
-	return true;
+
+//============================================================================
+void QtAdvancedStylesheetPrivate::finishStyleChange()
+{
+	// The pending work belongs to the previous style
+	cancelDeferredWork();
+	Icon = QIcon();
+	StylesheetReferences.clear();
+	TemplateReferences.clear();
+	StyleDirty = true;
+	updateIconSearchPath();
+	addFonts();
+	if (TransactionLevel)
+	{
+		TransactionChanges |= QtAdvancedStylesheet::StyleChanged;
+		return;
+	}
+	emit _this->currentStyleChanged(CurrentStyle);
+	emit _this->stylesheetChanged();
 }
 
 
 //============================================================================
-bool QtAdvancedStylesheetPrivate::parseStyleJsonFile()
+void QtAdvancedStylesheetPrivate::loadCompiledStyle()
 {
-	QDir Dir(_this->currentStylePath());
-	auto JsonFiles = Dir.entryInfoList({"*.json"}, QDir::Files);
-	if (JsonFiles.count() < 1)
+	const auto& Style = *Compiled;
+	Themes.clear();
+	for (int i = 0; i < Style.ThemeCount; ++i)
 	{
-		setError(QtAdvancedStylesheet::StyleJsonError, "Stylesheet folder does "
-			"not contain a style json file");
-		return false;
+		Themes.append(QString::fromUtf8(Style.Themes[i].Name));
 	}
 
-	if (JsonFiles.count() > 1)
+	StyleName = QString::fromUtf8(Style.Name);
+	DefaultTheme = QString::fromUtf8(Style.DefaultTheme);
+	IconFile.clear();
+	StyleVariables.clear();
+	for (int i = 0; i < Style.VariableCount; ++i)
 	{
-		setError(QtAdvancedStylesheet::StyleJsonError, "Stylesheet folder "
-			"contains multiple theme json files");
-		return false;
+		StyleVariables.insert(QString::fromUtf8(Style.Variables[i].Name),
+			QString::fromUtf8(Style.Variables[i].Value));
 	}
 
-	QFile StyleJsonFile(JsonFiles[0].absoluteFilePath());
-	StyleJsonFile.open(QIODevice::ReadOnly);
-
-	auto JsonData = StyleJsonFile.readAll();
-	QJsonParseError ParseError;
-	auto JsonDocument = QJsonDocument::fromJson(JsonData, &ParseError);
-	if (JsonDocument.isNull())
+	PaletteBaseColor = QString::fromUtf8(Style.PaletteBaseColor);
+	PaletteColors.clear();
+	PaletteCache.clear();
+	for (int i = 0; i < Style.PaletteEntryCount; ++i)
 	{
-		setError(QtAdvancedStylesheet::StyleJsonError, "Loading style json file "
-			"caused error: " + ParseError.errorString());
-		return false;
+		const auto& Entry = Style.PaletteEntries[i];
+		PaletteColors.append({QPalette::ColorGroup(Entry.Group),
+			QPalette::ColorRole(Entry.Role), QString::fromUtf8(Entry.ColorVariable)});
 	}
 
-	auto json = JsonStyleParam = JsonDocument.object();
-	StyleName = json.value("name").toString();
-	if (StyleName.isEmpty())
+	// The resource and icon color sections are rebuilt as JSON objects
+	// because the color replace lists are created from the JSON parameters
+	auto toJson = [](const CompiledColorReplaceList& List)
 	{
-		setError(QtAdvancedStylesheet::StyleJsonError, "No key \"name\" found "
-			"in style json file");
-		return false;
-	}
+		QJsonObject Object;
+		for (int i = 0; i < List.EntryCount; ++i)
+		{
+			Object.insert(QString::fromUtf8(List.Entries[i].TemplateColor),
+				QString::fromUtf8(List.Entries[i].Color));
+		}
+		return Object;
+	};
 
-	QMap<QString, QString> Variables;
-	auto jvariables = json.value("variables").toObject();
-	for (const auto& key : jvariables.keys())
+	QJsonObject Json;
+	Json.insert("name", StyleName);
+	Json.insert("default_theme", DefaultTheme);
+	Json.insert("css_template", QString::fromUtf8(Style.CssTemplateName));
+	QJsonObject jresources;
+	for (int i = 0; i < Style.ResourceVariantCount; ++i)
 	{
-		Variables.insert(key, jvariables.value(key).toString());
+		jresources.insert(QString::fromUtf8(Style.ResourceVariants[i].Name),
+			toJson(Style.ResourceVariants[i]));
 	}
-
-	StyleVariables = Variables;
-	IconFile = json.value("icon").toString();
-	parsePaletteFromJson();
-
-	DefaultTheme = json.value("default_theme").toString();
-	if (DefaultTheme.isEmpty())
+	Json.insert("resources", jresources);
+	for (int i = 0; i < Style.IconColorsCount; ++i)
 	{
-		setError(QtAdvancedStylesheet::StyleJsonError, "No key \"default_theme\" found "
-			"in style json file");
-		return false;
+		Json.insert(QString::fromUtf8(Style.IconColors[i].Name), toJson(Style.IconColors[i]));
 	}
-
-	return true;
+	JsonStyleParam = Json;
 }
 
 
 //============================================================================
-void QtAdvancedStylesheetPrivate::parsePaletteFromJson()
+bool QtAdvancedStylesheetPrivate::loadCompiledTheme(const QString& Theme)
 {
-	PaletteBaseColor = QString();
-	PaletteColors.clear();
-	auto jPalette = JsonStyleParam.value("palette").toObject();
-	if (jPalette.isEmpty())
+	const auto ThemeName = Theme.toUtf8();
+	for (int i = 0; i < Compiled->ThemeCount; ++i)
 	{
-		return;
+		const auto& CompiledTheme = Compiled->Themes[i];
+		if (ThemeName != CompiledTheme.Name)
+		{
+			continue;
+		}
+
+		IsDarkTheme = CompiledTheme.IsDark;
+		QMap<QString, QString> ColorVariables;
+		for (int j = 0; j < CompiledTheme.ColorCount; ++j)
+		{
+			ColorVariables.insert(QString::fromUtf8(CompiledTheme.Colors[j].Name),
+				QString::fromUtf8(CompiledTheme.Colors[j].Value));
+		}
+		ThemeVariables = StyleVariables;
+		insertIntoMap(ThemeVariables, ColorVariables);
+		ThemeColors = ColorVariables;
+		VariableIdTablesDirty = true;
+		return true;
 	}
 
-	PaletteBaseColor = jPalette.value("base_color").toString();
-	parsePaletteColorGroup(jPalette, QPalette::Active);
-	parsePaletteColorGroup(jPalette, QPalette::Disabled);
-	parsePaletteColorGroup(jPalette, QPalette::Inactive);
+	setError(QtAdvancedStylesheet::ThemeXmlError, "Compiled style "
+		+ CurrentStyle + " does not contain the theme " + Theme);
+	return false;
 }
 
 
 //============================================================================
-void QtAdvancedStylesheetPrivate::parsePaletteColorGroup(QJsonObject& jPalette, QPalette::ColorGroup ColorGroup)
+void QtAdvancedStylesheetPrivate::addCompiledFonts()
 {
-	auto jColorGroup = jPalette.value(colorGroupString(ColorGroup)).toObject();
-	if (jColorGroup.isEmpty())
-	{
-		return;
-	}
-
-	for (auto itc = jColorGroup.constBegin(); itc != jColorGroup.constEnd(); ++itc)
+	for (int i = 0; i < Compiled->FontCount; ++i)
 	{
-		auto ColorRole = colorRoleFromString(itc.key());
-		if (QPalette::NoRole == ColorRole)
+		const auto& Font = Compiled->Fonts[i];
+		// The font data is static, so its address identifies the font
+		const auto FontKey = QString("compiled:%1").arg(quintptr(Font.Data), 0, 16);
+		if (RegisteredFonts->contains(FontKey))
 		{
 			continue;
 		}
-
-		this->PaletteColors.append({ColorGroup, ColorRole, itc.value().toString()});
-		if (ColorGroup != QPalette::Active)
+		if (QFontDatabase::addApplicationFontFromData(QByteArray::fromRawData(
+			reinterpret_cast<const char*>(Font.Data), Font.Size)) >= 0)
 		{
-			continue;
+			RegisteredFonts->insert(FontKey);
 		}
 	}
 }
 
 
 //============================================================================
-void QtAdvancedStylesheetPrivate::replaceColor(QByteArray& Content,
-	const QString& TemplateColor, const QString& ThemeColor) const
+QString QtAdvancedStylesheet::currentStyle() const
 {
-	Content.replace(TemplateColor.toLatin1(), ThemeColor.toLatin1());
+	return d->CurrentStyle;
 }
 
 
 //============================================================================
-tColorReplaceList QtAdvancedStylesheetPrivate::parseColorReplaceList(const QJsonObject& JsonObject) const
+QString QtAdvancedStylesheet::currentStylePath() const
 {
-	// Fill the color replace list with the values read from style json file
-	tColorReplaceList ColorReplaceList;
-	for (auto it = JsonObject.constBegin(); it != JsonObject.constEnd(); ++it)
+	return d->StylesDir + "/" + d->CurrentStyle;
+}
+
+
+//============================================================================
+QString QtAdvancedStylesheet::outputDirPath() const
+{
+	return d->OutputDir;
+}
+
+
+//============================================================================
+void QtAdvancedStylesheet::setOutputDirPath(const QString& Path)
+{
+	d->OutputDir = Path;
+	d->OutputDirty = true;
+	d->updateIconSearchPath();
+}
+
+
+//============================================================================
+QString QtAdvancedStylesheet::iconUrlPrefix() const
+{
+	return d->IconUrlPrefix;
+}
+
+
+//============================================================================
+void QtAdvancedStylesheet::setIconUrlPrefix(const QString& Prefix)
+{
+	// QDir::setSearchPaths() ignores prefixes with less than two characters
+	// or with characters that are no letters or digits
+	const bool Valid = Prefix.size() >= 2 && std::all_of(Prefix.begin(), Prefix.end(),
+		[](const QChar& Char) { return Char.isLetterOrNumber(); });
+	if (!Valid)
 	{
-		auto TemplateColor = it.key();
-		auto ThemeColor = it.value().toString();
-		// If the color starts with an hashtag, then we have a real color value
-		// If it does not start with # then it is a theme variable
-		if (!ThemeColor.startsWith('#'))
-		{
-			ThemeColor = _this->themeVariableValue(ThemeColor);
-		}
-		ColorReplaceList.append({TemplateColor, ThemeColor});
+		qWarning() << "QtAdvancedStylesheet: icon URL prefix" << Prefix
+			<< "must consist of at least two letters or digits";
+		return;
 	}
 
-	return ColorReplaceList;
+	if (d->IconUrlPrefix == Prefix)
+	{
+		return;
+	}
+
+	// The prefix is part of the url() values of the generated stylesheet
+	// and of the shared output cache key
+	d->assignIconUrlPrefix(Prefix);
+	d->OutputDirty = true;
+	d->updateIconSearchPath();
 }
 
 
 //============================================================================
-bool QtAdvancedStylesheetPrivate::generateResourcesFor(const QString& SubDir,
-	const QJsonObject& JsonObject, const QFileInfoList& Entries)
+QString QtAdvancedStylesheet::currentStyleOutputPath() const
 {
-	const QString OutputDir = _this->currentStyleOutputPath() + "/" + SubDir;
-	if (!QDir().mkpath(OutputDir))
+	if (d->OutputCacheKey.isEmpty())
 	{
-		setError(QtAdvancedStylesheet::ResourceGeneratorError, "Error "
-			"creating resource output folder: " + OutputDir);
-		return false;
+		return outputDirPath() + "/" + d->CurrentStyle;
 	}
+	return outputDirPath() + "/" + d->CurrentStyle + "/" + d->OutputCacheKey;
+}
 
-	auto ColorReplaceList = parseColorReplaceList(JsonObject);
 
-	// Now loop through all resources svg files and replace the colors
-	for (const auto& Entry : Entries)
+//============================================================================
+bool QtAdvancedStylesheet::isSharedOutputCacheEnabled() const
+{
+	return d->SharedOutputCache;
+}
+
+
+//============================================================================
+void QtAdvancedStylesheet::setSharedOutputCacheEnabled(bool Enabled)
+{
+	d->SharedOutputCache = Enabled;
+	d->OutputDirty = true;
+	d->updateOutputCacheKey();
+}
+
+
+//============================================================================
+QString QtAdvancedStylesheet::themeVariableValue(const QString& VariableId) const
+{
+	return d->ThemeVariables.value(VariableId, QString());
+}
+
+
+//============================================================================
+QColor QtAdvancedStylesheet::themeColor(const QString& VariableId) const
+{
+	auto ColorString = d->ThemeColors.value(VariableId, QString());
+	if (ColorString.isEmpty())
 	{
-		QFile SvgFile(Entry.absoluteFilePath());
-		SvgFile.open(QIODevice::ReadOnly);
-		auto Content = SvgFile.readAll();
-		SvgFile.close();
-		_this->replaceSvgColors(Content, ColorReplaceList);
-		QString OutputFilename = OutputDir + "/" + Entry.fileName();
-		QFile OutputFile(OutputFilename);
-		OutputFile.open(QIODevice::WriteOnly);
-		OutputFile.write(Content);
-		OutputFile.close();
+		return QColor();
 	}
 
-	return true;
+	return QColor(ColorString);
 }
 
 
 //============================================================================
-const tColorReplaceList& QtAdvancedStylesheetPrivate::iconColorReplaceList() const
+void QtAdvancedStylesheet::setThemeVariableIds(const char* const* VariableIds, int Count)
 {
-	if (IconColorReplaceList.count())
+	d->VariableIds.clear();
+	for (int i = 0; i < Count; ++i)
 	{
-		return IconColorReplaceList;
+		d->VariableIds.append(QString::fromUtf8(VariableIds[i]));
 	}
+	d->VariableIdTablesDirty = true;
+}
+
 
-	auto jicon_colors = JsonStyleParam.value("icon_colors").toObject();
-	if (jicon_colors.isEmpty())
+//============================================================================
+QColor QtAdvancedStylesheet::themeColorById(int Id) const
+{
+	if (d->VariableIdTablesDirty)
 	{
-		return IconColorReplaceList;
+		d->updateVariableIdTables();
 	}
-
-	IconColorReplaceList = parseColorReplaceList(jicon_colors);
-	return IconColorReplaceList;
+	return (Id >= 0 && Id < d->VariableIdColors.size()) ? d->VariableIdColors[Id] : QColor();
 }
 
 
 //============================================================================
-void QtAdvancedStylesheet::replaceSvgColors(QByteArray& SvgContent,
-	const tColorReplaceList& ColorReplaceList)
+QString QtAdvancedStylesheet::themeVariableValueById(int Id) const
 {
-	const tColorReplaceList& ReplaceList = ColorReplaceList.isEmpty() ?
-		d->iconColorReplaceList() : ColorReplaceList;
-	for (const auto& Replace : ReplaceList)
+	if (d->VariableIdTablesDirty)
 	{
-		d->replaceColor(SvgContent, Replace.first, Replace.second);
+		d->updateVariableIdTables();
 	}
+	return (Id >= 0 && Id < d->VariableIdValues.size()) ? d->VariableIdValues[Id] : QString();
 }
 
 
 //============================================================================
-QIcon QtAdvancedStylesheet::loadThemeAwareSvgIcon(const QString& Filename)
+bool QtAdvancedStylesheet::compileThemeVariableIds(QIODevice& Device,
+	const QString& Namespace)
 {
-	QFile SvgFile(Filename);
-	SvgFile.open(QIODevice::ReadOnly);
-	auto Content = SvgFile.readAll();
-	return QIcon(new CSVGIconEngine(Content, this));
+	d->clearError();
+	if (d->JsonStyleParam.isEmpty() || d->Compiled)
+	{
+		d->setError(StyleJsonError, "Compiling requires a style that has been "
+			"loaded from the styles dir");
+		return false;
+	}
+
+	static const QRegularExpression IdentifierRegex("^[A-Za-z_][A-Za-z0-9_]*$");
+	if (!IdentifierRegex.match(Namespace).hasMatch())
+	{
+		d->setError(StyleJsonError, "Invalid namespace " + Namespace);
+		return false;
+	}
+
+	// The ids cover the style variables and the colors of all themes. The
+	// themes are parsed with the same code that loads them at runtime.
+	QStringList Names = d->StyleVariables.keys();
+	const auto ThemeVariables = d->ThemeVariables;
+	const auto ThemeColors = d->ThemeColors;
+	const bool IsDarkTheme = d->IsDarkTheme;
+	for (const auto& Theme : d->Themes)
+	{
+		if (!d->parseThemeFile(Theme + ".xml"))
+		{
+			break;
+		}
+		Names += d->ThemeColors.keys();
+	}
+	d->ThemeVariables = ThemeVariables;
+	d->ThemeColors = ThemeColors;
+	d->IsDarkTheme = IsDarkTheme;
+	d->VariableIdTablesDirty = true;
+	if (d->Error != NoError)
+	{
+		return false;
+	}
+	Names.removeDuplicates();
+	Names.sort();
+
+	// Different names may map to the same identifier and a name may
+	// collide with the generated symbols - both would produce a
+	// header that does not compile
+	static const QRegularExpression InvalidCharacters("[^A-Za-z0-9_]");
+	QStringList Identifiers;
+	QMap<QString, QString> IdentifierNames;
+	IdentifierNames.insert("eVariable", "eVariable");
+	IdentifierNames.insert("VariableCount", "VariableCount");
+	IdentifierNames.insert("VariableNames", "VariableNames");
+	IdentifierNames.insert("registerVariableIds", "registerVariableIds");
+	for (const auto& Name : Names)
+	{
+		auto Identifier = QString(Name).replace(InvalidCharacters, "_");
+		if (Identifier.at(0).isDigit())
+		{
+			Identifier.prepend('_');
+		}
+		if (IdentifierNames.contains(Identifier))
+		{
+			d->setError(StyleJsonError, QString("The variable %1 collides with %2 "
+				"- both map to the identifier %3").arg(Name)
+				.arg(IdentifierNames.value(Identifier)).arg(Identifier));
+			return false;
+		}
+		IdentifierNames.insert(Identifier, Name);
+		Identifiers.append(Identifier);
+	}
+
+	const auto Guard = Namespace.toUpper().toUtf8() + "_H";
+	QByteArray Out = "// Generated by acss_stylec from the style "
+		+ d->CurrentStyle.toUtf8() + " - do not edit\n"
+		"#ifndef " + Guard + "\n#define " + Guard + "\n\n"
+		"#include <QtAdvancedStylesheet.h>\n\n"
+		"namespace " + Namespace.toUtf8() + "\n{\n"
+		"/**\n * Ids for QtAdvancedStylesheet::themeColorById() and\n"
+		" * QtAdvancedStylesheet::themeVariableValueById()\n */\n"
+		"enum eVariable\n{\n";
+	for (const auto& Identifier : Identifiers)
+	{
+		Out += "\t" + Identifier.toUtf8() + ",\n";
+	}
+	Out += "\tVariableCount\n};\n\n"
+		"constexpr const char* VariableNames[VariableCount] = {\n";
+	for (const auto& Name : Names)
+	{
+		Out += "\t" + cStringLiteral(Name.toUtf8()) + ",\n";
+	}
+	Out += "};\n\n"
+		"/**\n * Registers the ids - call it once before you use the id based accessors\n */\n"
+		"inline void registerVariableIds(acss::QtAdvancedStylesheet& Stylesheet)\n{\n"
+		"\tStylesheet.setThemeVariableIds(VariableNames, VariableCount);\n}\n"
+		"} // namespace " + Namespace.toUtf8() + "\n\n"
+		"#endif // " + Guard + "\n";
+
+	if (Device.write(Out) != Out.size())
+	{
+		d->setError(CssExportError, "Writing variable ids failed: " + Device.errorString());
+		return false;
+	}
+	return true;
 }
 
 
 //============================================================================
-QtAdvancedStylesheet::QtAdvancedStylesheet(QObject* parent) :
-	QObject(parent),
-	d(new QtAdvancedStylesheetPrivate(this))
+tThemeSnapshotPtr QtAdvancedStylesheet::themeSnapshot() const
 {
+	// Each thread caches the last snapshot it read. As long as the
+	// generation did not change, the cached pointer is returned without
+	// touching the shared reference count. The cache keeps the snapshot
+	// alive until the thread reads a newer one.
+	struct SnapshotCache
+	{
+		int InstanceId = 0;
+		int Generation = -1;
+		tThemeSnapshotPtr Snapshot;
+	};
+	static thread_local SnapshotCache Cache;
+
+	const int Generation = d->SnapshotGeneration.loadAcquire();
+	if (Cache.InstanceId == d->InstanceId && Cache.Generation == Generation)
+	{
+		return Cache.Snapshot;
+	}
 
+	// A newer snapshot may have been published in the meantime, so the
+	// generation is taken from the loaded snapshot
+	Cache.Snapshot = std::atomic_load(&d->Snapshot);
+	Cache.InstanceId = d->InstanceId;
+	Cache.Generation = Cache.Snapshot->generation();
+	return Cache.Snapshot;
 }
 
 
 //============================================================================
-QtAdvancedStylesheet::~QtAdvancedStylesheet()
+void QtAdvancedStylesheet::setThemeVariableValue(const QString& VariableId, const QString& Value)
 {
-	delete d;
+	auto itv = d->ThemeVariables.constFind(VariableId);
+	if (itv != d->ThemeVariables.constEnd() && itv.value() == Value)
+	{
+		return;
+	}
+
+	d->DirtyVariables.insert(VariableId);
+	if (d->TransactionLevel)
+	{
+		d->TransactionChanges |= VariablesChanged;
+	}
+	d->ThemeVariables.insert(VariableId, Value);
+	d->VariableIdTablesDirty = true;
+	auto it = d->ThemeColors.find(VariableId);
+	if (it != d->ThemeColors.end())
+	{
+		it.value() = Value;
+	}
 }
 
 
 //============================================================================
-void QtAdvancedStylesheet::setStylesDirPath(const QString& DirPath)
+bool QtAdvancedStylesheet::setCurrentTheme(const QString& Theme)
 {
-	d->StylesDir = DirPath;
-	QDir Dir(d->StylesDir);
-	d->Styles = Dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+	d->clearError();
+	if (d->JsonStyleParam.isEmpty())
+	{
+		return false;
+	}
+
+	const auto OldVariables = d->ThemeVariables;
+	const bool Result = d->Compiled ? d->loadCompiledTheme(Theme)
+		: d->parseThemeFile(Theme + ".xml");
+	if (!Result)
+	{
+		return false;
+	}
+	d->markChangedVariables(OldVariables, d->ThemeVariables);
+
+	d->CurrentTheme = Theme;
+	if (d->TransactionLevel)
+	{
+		d->TransactionChanges |= ThemeChanged;
+		return true;
+	}
+	emit currentThemeChanged(d->CurrentTheme);
+	return true;
 }
 
 
 //============================================================================
-QString QtAdvancedStylesheet::stylesDirPath() const
+void QtAdvancedStylesheet::setDefaultTheme()
 {
-	return d->StylesDir;
+	setCurrentTheme(d->DefaultTheme);
 }
 
 
 //============================================================================
-bool QtAdvancedStylesheet::setCurrentStyle(const QString& Style)
+bool QtAdvancedStylesheetPrivate::runUpdateStages(bool& StylesheetUpdated)
 {
-	d->clearError();
-	d->CurrentStyle = Style;
-	QDir Dir(path(ThemesLocation));
-	d->Themes = Dir.entryList({"*.xml"}, QDir::Files);
-	for (auto& Theme : d->Themes)
+	// Each stage only runs, if its inputs changed since the last update
+	StylesheetUpdated = false;
+	const int Stages = dirtyUpdateStages();
+	if (!Stages)
 	{
-		Theme.replace(".xml", "");
+		return true;
 	}
-	auto Result = d->parseStyleJsonFile();
-	QDir::addSearchPath("icon", currentStyleOutputPath());
-	d->addFonts();
-	emit currentStyleChanged(d->CurrentStyle);
-	emit stylesheetChanged();
-	return Result;
-}
 
+	if (Stages & PaletteStage)
+	{
+		_this->updateApplicationPaletteColors();
+	}
 
-//============================================================================
-QString QtAdvancedStylesheet::currentStyle() const
-{
-	return d->CurrentStyle;
-}
+	// In shared output cache mode, the lock is held until the resources and
+	// the stylesheet of the entry have been written and published
+	std::unique_ptr<QLockFile> SharedOutputLock;
+	bool SharedOutputPublished = false;
+	if (SharedOutputCache && !LivePreview && (Stages & (ResourcesStage | StylesheetStage)))
+	{
+		updateOutputCacheKey();
+		SharedOutputLock = lockSharedOutput();
+		if (!SharedOutputLock)
+		{
+			return false;
+		}
+		SharedOutputPublished = QFile::exists(sharedOutputStampFile());
+	}
+
+	// In live preview mode, nothing is written to disk and the dirty state
+	// is kept for the final update when the preview is committed
+	if ((Stages & ResourcesStage) && !LivePreview && !SharedOutputPublished
+	 && !generateAllResources())
+	{
+		return false;
+	}
 
+	if ((Stages & IconsStage) && DeferredWork && !LivePreview)
+	{
+		// Visible icons are updated when they are painted, the icons of
+		// hidden windows when the event loop is idle
+		IconColorReplaceLists.clear();
+		CSVGIconEngine::invalidateAllIcons();
+		enqueueDeferredWork("icons", HighPriority, []()
+		{
+			return CSVGIconEngine::updateOutdatedIcons(8);
+		});
+	}
+	else if (Stages & IconsStage)
+	{
+		IconColorReplaceLists.clear();
+		CSVGIconEngine::updateAllIcons();
+	}
 
-//============================================================================
-QString QtAdvancedStylesheet::currentStylePath() const
-{
-	return d->StylesDir + "/" + d->CurrentStyle;
+	if ((Stages & (ResourcesStage | IconsStage)) && !LivePreview)
+	{
+		publishRecolorData();
+	}
+
+	if ((Stages & StylesheetStage) && !generateStylesheet()
+	 && (Error != QtAdvancedStylesheet::NoError))
+	{
+		return false;
+	}
+
+	// Other processes must not see the stamp before the stylesheet exists
+	if (SharedOutputLock && !SharedOutputPublished && (Stages & StylesheetStage)
+	 && !publishSharedOutput())
+	{
+		return false;
+	}
+
+	if (!LivePreview)
+	{
+		publishThemeSnapshot();
+		clearDirtyState();
+	}
+	StylesheetUpdated = true;
+	return true;
 }
 
 
 //============================================================================
-QString QtAdvancedStylesheet::outputDirPath() const
+bool QtAdvancedStylesheet::updateStylesheet()
 {
-	return d->OutputDir;
+	if (d->TransactionLevel)
+	{
+		return true;
+	}
+
+	bool StylesheetUpdated;
+	if (!d->runUpdateStages(StylesheetUpdated))
+	{
+		return false;
+	}
+
+	if (StylesheetUpdated)
+	{
+		emit stylesheetChanged();
+	}
+	return true;
 }
 
 
 //============================================================================
-void QtAdvancedStylesheet::setOutputDirPath(const QString& Path)
+void QtAdvancedStylesheet::beginTransaction()
 {
-	d->OutputDir = Path;
+	d->TransactionLevel++;
 }
 
 
 //============================================================================
-QString QtAdvancedStylesheet::currentStyleOutputPath() const
+bool QtAdvancedStylesheet::commitTransaction()
 {
-	return outputDirPath() + "/" + d->CurrentStyle;
+	if (d->TransactionLevel <= 0)
+	{
+		return false;
+	}
+
+	if (--d->TransactionLevel > 0)
+	{
+		return true;
+	}
+
+	const bool StylesheetDirty = d->dirtyUpdateStages() & QtAdvancedStylesheetPrivate::StylesheetStage;
+	bool StylesheetUpdated;
+	const bool Result = d->runUpdateStages(StylesheetUpdated);
+	auto Changes = d->TransactionChanges;
+	d->TransactionChanges = NoChange;
+	if (StylesheetUpdated && StylesheetDirty)
+	{
+		Changes |= StylesheetChanged;
+	}
+
+	// A transaction only reports its changes via changesCommitted() - the
+	// single change signals are reserved for non transactional calls
+	if (Changes != NoChange)
+	{
+		emit changesCommitted(Changes);
+	}
+	return Result;
 }
 
 
 //============================================================================
-QString QtAdvancedStylesheet::themeVariableValue(const QString& VariableId) const
+bool QtAdvancedStylesheet::isTransactionActive() const
 {
-	return d->ThemeVariables.value(VariableId, QString());
+	return d->TransactionLevel > 0;
 }
 
 
 //============================================================================
-QColor QtAdvancedStylesheet::themeColor(const QString& VariableId) const
+void QtAdvancedStylesheet::beginLivePreview()
 {
-	auto ColorString = d->ThemeColors.value(VariableId, QString());
-	if (ColorString.isEmpty())
+	if (d->LivePreview)
 	{
-		return QColor();
+		return;
 	}
 
-	return QColor(ColorString);
+	if (!d->LivePreviewFrameTimer)
+	{
+		d->LivePreviewFrameTimer = new QTimer(this);
+		d->LivePreviewFrameTimer->setSingleShot(true);
+		d->LivePreviewFrameTimer->setInterval(16);
+		connect(d->LivePreviewFrameTimer, &QTimer::timeout, this,
+			[this]() { d->applyLivePreviewFrame(); });
+		d->LivePreviewPauseTimer = new QTimer(this);
+		d->LivePreviewPauseTimer->setSingleShot(true);
+		d->LivePreviewPauseTimer->setInterval(200);
+		connect(d->LivePreviewPauseTimer, &QTimer::timeout, this,
+			[this]() { d->applyLivePreviewPause(); });
+	}
+
+	d->LivePreview = true;
+	d->LivePreviewSavedVariables = d->ThemeVariables;
+	d->LivePreviewSavedColors = d->ThemeColors;
 }
 
 
 //============================================================================
-void QtAdvancedStylesheet::setThemeVariableValue(const QString& VariableId, const QString& Value)
+void QtAdvancedStylesheet::setLivePreviewVariable(const QString& VariableId,
+	const QString& Value)
 {
-	d->ThemeVariables.insert(VariableId, Value);
-	auto it = d->ThemeColors.find(VariableId);
-	if (it != d->ThemeColors.end())
+	if (!d->LivePreview)
 	{
-		it.value() = Value;
+		beginLivePreview();
+	}
+
+	d->LivePreviewPending.insert(VariableId, Value);
+	if (!d->LivePreviewFrameTimer->isActive())
+	{
+		d->LivePreviewFrameTimer->start();
 	}
+	d->LivePreviewPauseTimer->start();
 }
 
 
 //============================================================================
-bool QtAdvancedStylesheet::setCurrentTheme(const QString& Theme)
+bool QtAdvancedStylesheet::commitLivePreview()
 {
-	d->clearError();
-	if (d->JsonStyleParam.isEmpty())
+	if (!d->LivePreview)
 	{
 		return false;
 	}
 
-	if (!d->parseThemeFile(Theme + ".xml"))
+	for (auto itc = d->LivePreviewPending.constBegin(); itc != d->LivePreviewPending.constEnd(); ++itc)
 	{
-		return false;
+		setThemeVariableValue(itc.key(), itc.value());
 	}
-
-	d->CurrentTheme = Theme;
-	emit currentThemeChanged(d->CurrentTheme);
-	return true;
+	d->LivePreviewPending.clear();
+	d->stopLivePreview();
+	return updateStylesheet();
 }
 
 
 //============================================================================
-void QtAdvancedStylesheet::setDefaultTheme()
+void QtAdvancedStylesheet::cancelLivePreview()
 {
-	setCurrentTheme(d->DefaultTheme);
+	if (!d->LivePreview)
+	{
+		return;
+	}
+
+	d->LivePreviewPending.clear();
+	d->markChangedVariables(d->ThemeVariables, d->LivePreviewSavedVariables);
+	d->ThemeVariables = d->LivePreviewSavedVariables;
+	d->ThemeColors = d->LivePreviewSavedColors;
+	d->VariableIdTablesDirty = true;
+	d->stopLivePreview();
+	updateStylesheet();
 }
 
 
 //============================================================================
-bool QtAdvancedStylesheet::updateStylesheet()
+bool QtAdvancedStylesheet::isLivePreviewActive() const
 {
-	if (!processStyleTemplate())
-	{
-		return false;
-	}
-
-	d->IconColorReplaceList.clear();
-	CSVGIconEngine::updateAllIcons();
-	if (!d->generateStylesheet() && (error() != QtAdvancedStylesheet::NoError))
-	{
-		return false;
-	}
-
-	emit stylesheetChanged();
-	return true;
+	return d->LivePreview;
 }
 
 
@@ -974,7 +4301,16 @@ QString QtAdvancedStylesheet::currentTheme() const
 //============================================================================
 QString QtAdvancedStylesheet::styleSheet() const
 {
-	return d->Stylesheet;
+	// The UTF-16 copy is not cached - the caller usually passes it to
+	// QApplication::setStyleSheet() which keeps its own copy
+	return QString::fromUtf8(d->StylesheetUtf8);
+}
+
+
+//============================================================================
+QByteArray QtAdvancedStylesheet::styleSheetUtf8() const
+{
+	return d->StylesheetUtf8;
 }
 
 
@@ -985,6 +4321,17 @@ const QIcon& QtAdvancedStylesheet::styleIcon() const
 	{
 		d->Icon = QIcon(currentStylePath() + "/" + d->IconFile);
 	}
+	else if (d->Icon.isNull() && d->Compiled && d->Compiled->IconSvgSize)
+	{
+		QSvgRenderer Renderer(QByteArray::fromRawData(d->Compiled->IconSvg,
+			d->Compiled->IconSvgSize));
+		QPixmap Pixmap(128, 128);
+		Pixmap.fill(Qt::transparent);
+		QPainter Painter(&Pixmap);
+		Renderer.render(&Painter);
+		Painter.end();
+		d->Icon = QIcon(Pixmap);
+	}
 
 	return d->Icon;
 }
@@ -1008,13 +4355,16 @@ const QStringList& QtAdvancedStylesheet::themes() const
 QString QtAdvancedStylesheet::processStylesheetTemplate(const QString& Template,
 	const QString& OutputFile)
 {
-	auto Stylesheet = Template;
-	d->replaceStylesheetVariables(Stylesheet);
+	auto Stylesheet = d->renderStyleTemplate(Template.toUtf8());
+	d->replaceIconUrlPrefix(Stylesheet);
+	const auto References = d->findReferencedResources(Stylesheet);
+	d->TemplateReferences += References;
+	d->generateMissingResources(References);
 	if (!OutputFile.isEmpty())
 	{
 		d->storeStylesheet(Stylesheet, OutputFile);
 	}
-	return Stylesheet;
+	return QString::fromUtf8(Stylesheet);
 }
 
 
@@ -1025,6 +4375,13 @@ const QMap<QString, QString>& QtAdvancedStylesheet::themeColorVariables() const
 }
 
 
+//============================================================================
+const QMap<QString, QString>& QtAdvancedStylesheet::themeVariables() const
+{
+	return d->ThemeVariables;
+}
+
+
 //============================================================================
 QtAdvancedStylesheet::eError QtAdvancedStylesheet::error() const
 {
@@ -1056,17 +4413,70 @@ QString QtAdvancedStylesheet::path(eLocation Location) const
 //============================================================================
 bool QtAdvancedStylesheet::generateResources()
 {
-	QDir ResourceDir(path(QtAdvancedStylesheet::ResourceTemplatesLocation));
-	auto Entries = ResourceDir.entryInfoList({"*.svg"}, QDir::Files);
+	if (!d->SharedOutputCache)
+	{
+		return d->generateAllResources();
+	}
+
+	d->updateOutputCacheKey();
+	const auto StampFile = d->sharedOutputStampFile();
+	if (QFile::exists(StampFile))
+	{
+		return true;
+	}
+
+	// Only one process generates the output for a certain cache key. All
+	// other processes wait here and reuse the published output. The entry
+	// is published by the stylesheet stage of updateStylesheet(), because
+	// the stylesheet is part of the entry.
+	const auto Lock = d->lockSharedOutput();
+	if (!Lock)
+	{
+		return false;
+	}
+	return QFile::exists(StampFile) || d->generateAllResources();
+}
 
-	auto jresources = d->JsonStyleParam.value("resources").toObject();
+
+//============================================================================
+bool QtAdvancedStylesheetPrivate::generateAllResources()
+{
+	// The templates are loaded only once for all variants. In lazy mode, only
+	// the referenced templates are loaded
+	QSet<QString> FileNames;
+	const bool ReferencedOnly = lazyResources() || deferResources();
+	if (ReferencedOnly)
+	{
+		for (const auto& Resource : StylesheetReferences + TemplateReferences)
+		{
+			FileNames.insert(Resource.section('/', 1));
+		}
+	}
+	auto Templates = resourceTemplates(ReferencedOnly ? &FileNames : nullptr);
+	SvgOptimizationStatistics = CSvgOptimizer::Statistics();
+	optimizeResourceTemplates(Templates, &SvgOptimizationStatistics);
+	auto jresources = JsonStyleParam.value("resources").toObject();
 	if (jresources.isEmpty())
 	{
-		d->setError(QtAdvancedStylesheet::StyleJsonError, "Key resources "
+		setError(QtAdvancedStylesheet::StyleJsonError, "Key resources "
 			"missing in style json file");
 		return false;
 	}
 
+	if (lazyResources())
+	{
+		return generateReferencedResources(Templates);
+	}
+
+	// The referenced resources are required for the next frame - all other
+	// resources are generated when the event loop is idle
+	if (deferResources())
+	{
+		const bool Result = generateReferencedResources(Templates);
+		deferResourceGeneration();
+		return Result;
+	}
+
 	// Process all resource generation variants
 	bool Result = true;
 	for (auto itc = jresources.constBegin(); itc != jresources.constEnd(); ++itc)
@@ -1074,17 +4484,172 @@ bool QtAdvancedStylesheet::generateResources()
 		auto Param = itc.value().toObject();
 		if (Param.isEmpty())
 		{
-			d->setError(QtAdvancedStylesheet::StyleJsonError, "Key resources "
+			setError(QtAdvancedStylesheet::StyleJsonError, "Key resources "
 				"missing in style json file");
 			Result = false;
 			continue;
 		}
-		if (!d->generateResourcesFor(itc.key(), Param, Entries))
+		if (!generateResourcesFor(itc.key(), Param, Templates))
+		{
+			Result = false;
+		}
+	}
+
+	return Result;
+}
+
+
+//============================================================================
+tResourceTemplates QtAdvancedStylesheetPrivate::resourceTemplates(
+	const QSet<QString>* FileNames) const
+{
+	tResourceTemplates Templates;
+	if (Compiled)
+	{
+		for (int i = 0; i < Compiled->ResourceCount; ++i)
+		{
+			const auto& Resource = Compiled->Resources[i];
+			const auto FileName = QString::fromUtf8(Resource.FileName);
+			if (!FileNames || FileNames->contains(FileName))
+			{
+				Templates.append({FileName, QByteArray::fromRawData(Resource.Data,
+					Resource.Size)});
+			}
+		}
+		return Templates;
+	}
+
+	const auto Dir = _this->path(QtAdvancedStylesheet::ResourceTemplatesLocation);
+	for (const auto& FileName : resourceTemplateNames())
+	{
+		if (FileNames && !FileNames->contains(FileName))
+		{
+			continue;
+		}
+		QFile SvgFile(Dir + "/" + FileName);
+		SvgFile.open(QIODevice::ReadOnly);
+		Templates.append({FileName, SvgFile.readAll()});
+	}
+	return Templates;
+}
+
+
+//============================================================================
+void QtAdvancedStylesheetPrivate::optimizeResourceTemplates(
+	tResourceTemplates& Templates, CSvgOptimizer::Statistics* Statistics) const
+{
+	if (!SvgOptimization)
+	{
+		return;
+	}
+
+	CSvgOptimizer Optimizer;
+	for (auto& Template : Templates)
+	{
+		Template.second = Optimizer.optimize(Template.second);
+	}
+	if (Statistics)
+	{
+		*Statistics = Optimizer.statistics();
+	}
+}
+
+
+//============================================================================
+QStringList QtAdvancedStylesheetPrivate::resourceTemplateNames() const
+{
+	if (!Compiled)
+	{
+		QDir ResourceDir(_this->path(QtAdvancedStylesheet::ResourceTemplatesLocation));
+		return ResourceDir.entryList({"*.svg"}, QDir::Files);
+	}
+
+	QStringList FileNames;
+	for (int i = 0; i < Compiled->ResourceCount; ++i)
+	{
+		FileNames.append(QString::fromUtf8(Compiled->Resources[i].FileName));
+	}
+	return FileNames;
+}
+
+
+//============================================================================
+QSet<QString> QtAdvancedStylesheetPrivate::findReferencedResources(
+	const QByteArray& Stylesheet) const
+{
+	QSet<QString> Resources;
+	const QByteArray UrlStart = "url(" + IconUrlPrefix.toUtf8() + ":";
+	int Pos = 0;
+	while ((Pos = Stylesheet.indexOf(UrlStart, Pos)) >= 0)
+	{
+		Pos += UrlStart.size();
+		const int End = Stylesheet.indexOf(')', Pos);
+		if (End < 0)
+		{
+			break;
+		}
+
+		auto Resource = Stylesheet.mid(Pos, End - Pos).trimmed();
+		while (Resource.startsWith('/'))
+		{
+			Resource.remove(0, 1);
+		}
+		Resources.insert(svgResourcePath(QString::fromUtf8(Resource)));
+		Pos = End;
+	}
+	return Resources;
+}
+
+
+//============================================================================
+void QtAdvancedStylesheetPrivate::generateMissingResources(const QSet<QString>& Resources)
+{
+	if (!lazyResources() && !deferResources())
+	{
+		return;
+	}
+
+	for (const auto& Resource : Resources)
+	{
+		_this->generateResource(Resource);
+	}
+}
+
+
+//============================================================================
+bool QtAdvancedStylesheetPrivate::generateReferencedResources(
+	const tResourceTemplates& Templates)
+{
+	const auto Referenced = StylesheetReferences + TemplateReferences;
+	auto jresources = JsonStyleParam.value("resources").toObject();
+	QSet<QString> Generated;
+	bool Result = true;
+	for (auto itc = jresources.constBegin(); itc != jresources.constEnd(); ++itc)
+	{
+		tResourceTemplates VariantTemplates;
+		for (const auto& Template : Templates)
+		{
+			const auto Resource = itc.key() + "/" + Template.first;
+			if (Referenced.contains(Resource))
+			{
+				VariantTemplates.append(Template);
+				Generated.insert(Resource);
+			}
+		}
+		if (!generateResourcesFor(itc.key(), itc.value().toObject(), VariantTemplates))
 		{
 			Result = false;
 		}
 	}
 
+	// Resources that are not generated again keep the colors of the last
+	// theme. They are not removed, because QIcon objects and QML images may
+	// still load them via their file names. They are marked as stale and
+	// generateResource() generates them again on the next access.
+	{
+		QMutexLocker Locker(&RecolorMutex);
+		GeneratedResources = Generated;
+	}
 	return Result;
 }
 
@@ -1093,6 +4658,13 @@ bool QtAdvancedStylesheet::generateResources()
 QPalette QtAdvancedStylesheet::generateThemePalette() const
 {
 	QPalette Palette = qApp->palette();
+	const auto CacheKey = d->paletteCacheKey(Palette);
+	auto it = d->PaletteCache.constFind(CacheKey);
+	if (it != d->PaletteCache.constEnd())
+	{
+		return it.value();
+	}
+
 	if (!d->PaletteBaseColor.isEmpty())
 	{
 		auto Color = themeColor(d->PaletteBaseColor);
@@ -1107,10 +4679,16 @@ QPalette QtAdvancedStylesheet::generateThemePalette() const
 		auto Color = themeColor(Entry.ColorVariable);
 		if (Color.isValid())
 		{
-			Palette.setColor(Entry.Group, Entry.Role, themeColor(Entry.ColorVariable));
+			Palette.setColor(Entry.Group, Entry.Role, Color);
 		}
 	}
 
+	// The cache only needs to hold the palettes of a few themes
+	if (d->PaletteCache.size() >= 16)
+	{
+		d->PaletteCache.clear();
+	}
+	d->PaletteCache.insert(CacheKey, Palette);
 	return Palette;
 }
 
@@ -1118,7 +4696,22 @@ QPalette QtAdvancedStylesheet::generateThemePalette() const
 //============================================================================
 void QtAdvancedStylesheet::updateApplicationPaletteColors()
 {
-	qApp->setPalette(generateThemePalette());
+	// Setting the palette sends palette change events to all widgets, so we
+	// only set it, if it really changed
+	auto Palette = generateThemePalette();
+	d->ChangedPaletteRoles = d->changedColorRoles(qApp->palette(), Palette);
+	if (d->ChangedPaletteRoles.isEmpty())
+	{
+		return;
+	}
+	qApp->setPalette(Palette);
+}
+
+
+//============================================================================
+QVector<QPalette::ColorRole> QtAdvancedStylesheet::changedPaletteRoles() const
+{
+	return d->ChangedPaletteRoles;
 }
 
 
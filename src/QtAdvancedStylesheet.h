@@ -33,18 +33,78 @@
 #include <QVector>
 #include <QPair>
 #include <QObject>
+#include <QPalette>
+#include <QSize>
+#include <QSharedPointer>
 
 #include "acss_globals.h"
+#include "SvgOptimizer.h"
+#include "SharedIconCache.h"
+#include "ThemeSnapshot.h"
 
 
 QT_FORWARD_DECLARE_CLASS(QIcon)
+QT_FORWARD_DECLARE_CLASS(QIODevice)
 
 namespace acss
 {
 struct QtAdvancedStylesheetPrivate;
+struct ThemeAwareIconSetPrivate;
+struct CompiledStyle;
+class QtAdvancedStylesheet;
 using QStringPair = QPair<QString, QString>;
 using tColorReplaceList = QVector<QStringPair>;
 
+/**
+ * Handle of a set of theme aware icons that are loaded in the background
+ * via QtAdvancedStylesheet::preloadThemeAwareSvgIcons().
+ * The handle is implicitly shared and cheap to copy. The background
+ * loading stops, when the last copy of the handle is destroyed.
+ */
+class ACSS_EXPORT CThemeAwareIconSet
+{
+private:
+	QSharedPointer<ThemeAwareIconSetPrivate> d; ///< private data (pimpl)
+	friend class QtAdvancedStylesheet;
+
+public:
+	/**
+	 * Creates an empty icon set
+	 */
+	CThemeAwareIconSet();
+
+	/**
+	 * Returns true, if all icons have been loaded
+	 */
+	bool isFinished() const;
+
+	/**
+	 * Blocks until all icons have been loaded
+	 */
+	void waitForFinished() const;
+
+	/**
+	 * Returns the absolute file paths of all icons in this set
+	 */
+	QStringList fileNames() const;
+
+	/**
+	 * Returns the absolute file paths of the icons that could not be read.
+	 * If the icons are still loading, the function waits until the loading
+	 * finished.
+	 */
+	QStringList failedFileNames() const;
+
+	/**
+	 * Returns the theme aware icon for the given file. If the icons are
+	 * still loading, the function waits until the loading finished.
+	 * The icon is the same as an icon created via loadThemeAwareSvgIcon().
+	 * Returns a null icon, if the file is not part of this set or if the
+	 * file could not be read.
+	 */
+	QIcon icon(const QString& Filename) const;
+}; // class CThemeAwareIconSet
+
 /**
  * Encapsulates all information about a single stylesheet based style
  */
@@ -64,6 +124,7 @@ public:
 		ThemeXmlError,
 		StyleJsonError,
 		ResourceGeneratorError,
+		SharedIconCacheError,
 	};
 
 	enum eLocation
@@ -73,6 +134,67 @@ public:
 		FontsLocation
 	};
 
+	/**
+	 * The changes that are reported by changesCommitted()
+	 */
+	enum eChange
+	{
+		NoChange = 0x00,
+		StyleChanged = 0x01,
+		ThemeChanged = 0x02,
+		VariablesChanged = 0x04,
+		StylesheetChanged = 0x08
+	};
+	Q_DECLARE_FLAGS(ChangeFlags, eChange)
+	Q_FLAG(ChangeFlags)
+
+	/**
+	 * Memory held by a QtAdvancedStylesheet object and by its theme aware
+	 * icons. All sizes are in bytes and count the heap memory of the data
+	 * without allocator and container overhead. Implicitly shared data is
+	 * counted once. Qt does not expose the storage of parsed JSON objects
+	 * and palettes, so StyleParameterBytes and PaletteCacheBytes are
+	 * estimates and not measured heap sizes - see estimatedBytes().
+	 * \see memoryUsage()
+	 */
+	struct MemoryUsage
+	{
+		qint64 StylesheetBytes = 0;///< generated UTF-8 stylesheet
+		qint64 StyleParameterBytes = 0;///< estimate: compact JSON size of the parsed style json file
+		qint64 VariableBytes = 0;///< style variables, theme colors and theme variables
+		qint64 IconTemplateBytes = 0;///< SVG templates of the theme aware icons
+		qint64 IconContentBytes = 0;///< recolored SVG data and recorded vector pictures of the icons
+		qint64 IconPixmapBytes = 0;///< pixmaps rendered by the theme aware icons
+		qint64 RecolorCacheBytes = 0;///< recolored SVG data cache of resourceSvgData()
+		qint64 ResourceTemplateBytes = 0;///< in-memory resource templates of compiled styles
+		qint64 PaletteCacheBytes = 0;///< estimate: one QBrush per color group and role of each cached palette
+		int IconEngineCount = 0;///< live theme aware icon engines
+		int IconPixmapCount = 0;
+		int UniqueIconTemplates = 0;///< icon templates with distinct content
+		int DuplicateIconTemplates = 0;///< unshared icon templates with the content of another template
+		qint64 DuplicateIconTemplateBytes = 0;///< bytes of duplicates that are not shared
+		int RecolorCacheEntries = 0;
+		int PaletteCacheEntries = 0;
+
+		/**
+		 * Returns the sum of all byte counts
+		 */
+		qint64 totalBytes() const
+		{
+			return StylesheetBytes + StyleParameterBytes + VariableBytes
+				+ IconTemplateBytes + IconContentBytes + IconPixmapBytes
+				+ RecolorCacheBytes + ResourceTemplateBytes + PaletteCacheBytes;
+		}
+
+		/**
+		 * Returns the part of totalBytes() that is estimated and not measured
+		 */
+		qint64 estimatedBytes() const
+		{
+			return StyleParameterBytes + PaletteCacheBytes;
+		}
+	};
+
 	/**
 	 * Default Constructor
 	 */
@@ -121,6 +243,13 @@ public:
 	 */
 	const QMap<QString, QString>& themeColorVariables() const;
 
+	/**
+	 * Returns all theme variables. The theme variables contain the style
+	 * variables, the theme colors and all variables that have been set via
+	 * setThemeVariableValue()
+	 */
+	const QMap<QString, QString>& themeVariables() const;
+
 	/**
 	 * Returns the absolute dir path for the given location
 	 */
@@ -143,13 +272,65 @@ public:
 	 * The output path is the outputDirPath() + the style name.
 	 * If your output path is C:/temp/styles and your style is qt_material
 	 * then this functions returns C:/temp/styles/qt_material
+	 * If the shared output cache is enabled, the output path also contains
+	 * the cache key of the current theme.
 	 */
 	QString currentStyleOutputPath() const;
 
+	/**
+	 * Returns true, if the shared output cache is enabled
+	 * \see setSharedOutputCacheEnabled()
+	 */
+	bool isSharedOutputCacheEnabled() const;
+
+	/**
+	 * Enables the shared output cache mode.
+	 * Use this mode, if several processes use the same outputDirPath().
+	 * In this mode, the output of each theme is stored in its own
+	 * subfolder of the style output folder. The folder name is a key that is
+	 * calculated from the style, the theme variables and the style files.
+	 * Only one process generates the resources and the stylesheet for a
+	 * certain key while holding a lock file. All files are published via
+	 * atomic renames and a process
+	 * that finds already published output reuses it instead of regenerating
+	 * it. Outdated cache entries are not removed automatically because
+	 * other processes may still use them. currentStyleOutputPath() and the
+	 * icon search path switch to the folder of the cache key immediately.
+	 */
+	void setSharedOutputCacheEnabled(bool Enabled);
+
+	/**
+	 * Returns the URL prefix that is used to access the generated style
+	 * resources.
+	 * \see setIconUrlPrefix()
+	 */
+	QString iconUrlPrefix() const;
+
+	/**
+	 * Sets the URL prefix that is used to access the generated style
+	 * resources. The default prefix is "icon". If another instance already
+	 * uses "icon", a new instance uses "icon" followed by its instance number,
+	 * e.g. "icon2", so several instances with different styles or output dirs
+	 * do not hide each others resources. Use iconUrlPrefix() to build URLs
+	 * for the resources of such an instance.
+	 * Each QtAdvancedStylesheet instance owns exactly one search path entry
+	 * for its prefix. The entry is replaced if the style or output dir changes.
+	 * All "icon:" URLs
+	 * in the CSS template are rewritten to the given prefix when the
+	 * stylesheet is generated. A new prefix marks the stylesheet and the
+	 * resources as outdated, so the next updateStylesheet() call
+	 * regenerates them.
+	 * Like QDir::setSearchPaths(), the function ignores prefixes that are
+	 * shorter than two characters or contain characters that are no letters
+	 * or digits.
+	 */
+	void setIconUrlPrefix(const QString& Prefix);
+
 	/**
 	 * Returns the value for the given theme variable.
 	 * For example themeVariable("primaryColor") may return "#ac2300".
 	 * Returns an empty string, if the given theme variable does not exist.
+	 * Only call this function from the GUI thread - see themeSnapshot().
 	 */
 	QString themeVariableValue(const QString& VariableId) const;
 
@@ -167,9 +348,47 @@ public:
 	 * Returns the color for the given VariableId.
 	 * If VariableId is not a color variable, then this function returns an invalid
 	 * QColor.
+	 * This function reads the mutable theme state and may only be called
+	 * from the GUI thread. Use themeSnapshot() in other threads.
 	 */
 	QColor themeColor(const QString& VariableId) const;
 
+	/**
+	 * Returns the snapshot of the theme state that has been committed by the
+	 * last updateStylesheet() call. The snapshot is immutable and stays
+	 * valid as long as you hold the pointer, even if the theme changes.
+	 * Before the first update, the function returns an empty snapshot.
+	 * This function is thread safe and does not take a mutex. If the theme
+	 * did not change since the last call in the same thread, it returns the
+	 * snapshot the thread read before.
+	 */
+	tThemeSnapshotPtr themeSnapshot() const;
+
+	/**
+	 * Assigns the variable names for the id based accessors
+	 * themeColorById() and themeVariableValueById(). The index of a name in
+	 * the given array is its id. The acss_stylec tool generates a header
+	 * with an enum of the ids and a registerVariableIds() function that
+	 * calls this function - see compileThemeVariableIds().
+	 */
+	void setThemeVariableIds(const char* const* VariableIds, int Count);
+
+	/**
+	 * Returns the color for the given variable id without a map lookup and
+	 * without parsing the color. The colors are parsed once after each
+	 * theme or variable change. Returns an invalid color, if the id is
+	 * unknown or if the variable is not a color variable.
+	 * Only call this function from the GUI thread.
+	 */
+	QColor themeColorById(int Id) const;
+
+	/**
+	 * Returns the value of the variable with the given id or an empty
+	 * string, if the id is unknown
+	 * \see themeColorById()
+	 */
+	QString themeVariableValueById(int Id) const;
+
 	/**
 	 * Returns the current set theme
 	 */
@@ -178,10 +397,20 @@ public:
 	/**
 	 * Returns the processed style stylesheet.
 	 * If the style or the theme of a style changed, you can read the new
-	 * stylesheet from this function
+	 * stylesheet from this function. The stylesheet is stored as UTF-8 and
+	 * each call converts it into a new QString - store the result, if you
+	 * need it several times, or use styleSheetUtf8() in hot paths.
 	 */
 	QString styleSheet() const;
 
+	/**
+	 * Returns the processed stylesheet as UTF-8 data.
+	 * The stylesheet is generated as UTF-8 and each styleSheet() call
+	 * converts it into a new QString. Use this function in hot paths and
+	 * whenever you do not need a QString, to avoid the conversion.
+	 */
+	QByteArray styleSheetUtf8() const;
+
 	/**
 	 * This function replaces the style variables in the given template with
 	 * the value of the registered style variables.
@@ -213,10 +442,18 @@ public:
 
 	/**
 	 * This function creates a palette with the theme colors of the currently
-	 * selected theme
+	 * selected theme.
+	 * Generated palettes are cached per theme color state.
 	 */
 	QPalette generateThemePalette() const;
 
+	/**
+	 * Returns the palette color roles that changed in at least one color
+	 * group during the last call of updateApplicationPaletteColors().
+	 * If the list is empty, the application palette has not been touched.
+	 */
+	QVector<QPalette::ColorRole> changedPaletteRoles() const;
+
 	/**
 	 * Read access to the Json object with all stlye parameters
 	 */
@@ -250,6 +487,331 @@ public:
 	 */
 	QIcon loadThemeAwareSvgIcon(const QString& Filename);
 
+	/**
+	 * Loads and recolors the given SVG files in parallel on worker threads
+	 * and returns immediately. Take the icons from the returned handle via
+	 * CThemeAwareIconSet::icon() - this is instant, if the loading has
+	 * finished. If PixmapSizes are given, the normal mode pixmaps for these
+	 * sizes and the current device pixel ratio are rendered in advance, too.
+	 * Use this function instead of many loadThemeAwareSvgIcon() calls to
+	 * build large menus and toolbars on startup.
+	 */
+	CThemeAwareIconSet preloadThemeAwareSvgIcons(const QStringList& Filenames,
+		const QList<QSize>& PixmapSizes = QList<QSize>());
+
+	/**
+	 * Preloads all SVG files in the given directory and its subdirectories.
+	 * The directory may be a resource path like ":/icons".
+	 * \see preloadThemeAwareSvgIcons()
+	 */
+	CThemeAwareIconSet preloadThemeAwareSvgIconDir(const QString& DirPath,
+		const QList<QSize>& PixmapSizes = QList<QSize>());
+
+	/**
+	 * Returns the SVG data of the given style resource with the colors of
+	 * the given resource variant. The ResourcePath contains the variant and
+	 * the file name - e.g. "primary/checkbox_checked.svg".
+	 * The recolored data is kept in an in-process cache until the theme
+	 * changes. The function does not need any generated output files.
+	 * This function is thread safe. The data is available after the first
+	 * updateStylesheet() call.
+	 */
+	QByteArray resourceSvgData(const QString& ResourcePath) const;
+
+	/**
+	 * Loads the given SVG file and replaces its colors with the icon colors
+	 * of the current theme like loadThemeAwareSvgIcon() does.
+	 * The recolored data is kept in the same cache as the resourceSvgData().
+	 * This function is thread safe.
+	 */
+	QByteArray themeAwareSvgData(const QString& Filename) const;
+
+	/**
+	 * Returns true, if the given name is a resource variant of the current
+	 * style like "primary" or "disabled".
+	 * This function is thread safe.
+	 */
+	bool isResourceVariant(const QString& Variant) const;
+
+	/**
+	 * Returns true, if lazy resource generation is enabled
+	 * \see setLazyResourceGenerationEnabled()
+	 */
+	bool isLazyResourceGenerationEnabled() const;
+
+	/**
+	 * Enables lazy resource generation.
+	 * By default, generateResources() generates all SVG resources for all
+	 * resource variants. In lazy mode, only the resources that are referenced
+	 * via icon URLs in the generated stylesheet and in the stylesheets
+	 * processed via processStylesheetTemplate() are generated eagerly. All
+	 * other resources are generated on first access via generateResource().
+	 * Resources of the last theme that have not been generated again stay
+	 * in the output folder with the old colors until generateResource()
+	 * generates them again. So access unreferenced resources only via
+	 * generateResource() or CQmlStyleUrlInterceptor - icon: URLs that are
+	 * resolved via the search path, e.g. QIcon("icon:primary/close.svg"),
+	 * may load a resource of the last theme.
+	 * Lazy generation is not used with a shared output cache, because other
+	 * processes use a published cache entry without the lock.
+	 */
+	void setLazyResourceGenerationEnabled(bool Enabled);
+
+	/**
+	 * Returns true, if deferred work is enabled
+	 * \see setDeferredWorkEnabled()
+	 */
+	bool isDeferredWorkEnabled() const;
+
+	/**
+	 * Enables deferred work.
+	 * By default, updateStylesheet() and setCurrentStyle() do all their work
+	 * before they return. If deferred work is enabled, only the work that is
+	 * required for the next frame is done immediately. The resources that
+	 * are not referenced by the stylesheets, the icons that are not visible,
+	 * the export of the CSS file and the fonts of other font families than
+	 * font_family are processed in small time slices when the event loop is
+	 * idle. Resources are generated on first access via generateResource()
+	 * until the deferred work is finished. Deferred resource generation is
+	 * not used in lazy mode. With a shared output cache, the resources and
+	 * the CSS export are never deferred.
+	 * Disabling deferred work runs all pending work.
+	 */
+	void setDeferredWorkEnabled(bool Enabled);
+
+	/**
+	 * Returns true, if there is pending deferred work
+	 */
+	bool hasDeferredWork() const;
+
+	/**
+	 * Runs all pending deferred work immediately. Use this function in tests
+	 * or before you access the generated files directly.
+	 */
+	void flushDeferredWork();
+
+	/**
+	 * Returns the absolute path of the generated file for the given resource
+	 * path like "primary/checkbox_checked.svg". In lazy mode, the file is
+	 * generated, if it does not exist yet. If PNG resources are enabled, the
+	 * path may also refer to a PNG file like "primary/checkbox_checked@2x.png".
+	 * Returns an empty string, if the given path is not a resource of the
+	 * current style.
+	 * This function is thread safe. The resources are available after the
+	 * first updateStylesheet() call.
+	 */
+	QString generateResource(const QString& ResourcePath);
+
+	/**
+	 * Returns true, if the SVG resources are optimized during generation
+	 * \see setSvgOptimizationEnabled()
+	 */
+	bool isSvgOptimizationEnabled() const;
+
+	/**
+	 * Enables an optimization pass for the SVG resource templates. The
+	 * templates are optimized via CSvgOptimizer before the colors are
+	 * replaced. This removes editor metadata, comments, unused definitions
+	 * and redundant groups and rounds the coordinates. Smaller files are
+	 * parsed faster each time Qt loads a resource.
+	 */
+	void setSvgOptimizationEnabled(bool Enabled);
+
+	/**
+	 * Returns the size savings of the SVG optimization of the last
+	 * generateResources() call
+	 */
+	CSvgOptimizer::Statistics svgOptimizationStatistics() const;
+
+	/**
+	 * Returns the key of the shared icon cache or an empty string, if the
+	 * shared icon cache is disabled
+	 * \see setSharedIconCacheKey()
+	 */
+	QString sharedIconCacheKey() const;
+
+	/**
+	 * Enables the shared icon cache. Use this cache, if several processes
+	 * use the same style and theme. The theme aware icons store their
+	 * rendered pixmaps in a shared memory segment with the given key and
+	 * size and use the pixmaps other processes rendered instead of rendering
+	 * them again. Each process keeps its own copy of the pixel data. See
+	 * CSharedIconCache for details.
+	 * An empty key disables the cache. The segment stays attached until the
+	 * process exits, so other instances with the same key reuse it. In Qt 5,
+	 * the size is limited to 2 GiB. Returns
+	 * false, if the shared memory segment could not be created or attached.
+	 */
+	bool setSharedIconCacheKey(const QString& Key, qint64 SizeBytes = 32 * 1024 * 1024);
+
+	/**
+	 * Returns the statistics of the shared icon cache
+	 */
+	CSharedIconCache::Statistics sharedIconCacheStatistics() const;
+
+	/**
+	 * Returns the device pixel ratios of the generated PNG resources
+	 * \see setRasterResourceScales()
+	 */
+	QVector<qreal> rasterResourceScales() const;
+
+	/**
+	 * Enables the generation of PNG files for the generated SVG resources.
+	 * For each scale, a PNG file is rendered next to each SVG file - e.g.
+	 * checkbox_checked.png for scale 1 and checkbox_checked@2x.png for scale
+	 * 2. The PNG files are rendered in parallel. The CSS template can then
+	 * reference the PNG files (url(icon:primary/checkbox_checked.png))
+	 * instead of the SVG files and Qt loads the @Nx file that matches the
+	 * device pixel ratio. Decoding small PNG files is much cheaper than
+	 * parsing SVG files. An empty list disables the PNG generation (default).
+	 * Qt only resolves integer @Nx suffixes, so the function ignores lists
+	 * with scales that are not positive integers.
+	 */
+	void setRasterResourceScales(const QVector<qreal>& Scales);
+
+	/**
+	 * Returns the logical size of the generated PNG resources
+	 * \see setRasterResourceSize()
+	 */
+	QSize rasterResourceSize() const;
+
+	/**
+	 * Sets the logical size of the generated PNG resources. If the size is
+	 * invalid (default), the size of each SVG file is used.
+	 */
+	void setRasterResourceSize(const QSize& Size);
+
+	/**
+	 * Returns all resources ("variant/file.svg") that are referenced by the
+	 * generated stylesheet and by the stylesheets that have been processed
+	 * via processStylesheetTemplate() since the last style change
+	 */
+	QStringList referencedResources() const;
+
+	/**
+	 * Returns all resources ("variant/file.svg") of all resource variants
+	 * that are not referenced by any stylesheet.
+	 * \see referencedResources()
+	 */
+	QStringList unreferencedResources() const;
+
+	/**
+	 * Returns the theme generation. The generation is incremented each time
+	 * the theme colors have been applied via updateStylesheet(). You can use
+	 * the generation to invalidate caches or as cache busting URL parameter.
+	 * This function is thread safe.
+	 */
+	int themeGeneration() const;
+
+	/**
+	 * Starts a transaction.
+	 * Within a transaction, setCurrentStyle(), setCurrentTheme() and
+	 * setThemeVariableValue() do not emit any signals and calls of
+	 * updateStylesheet() are deferred until the transaction is committed.
+	 * currentStyleChanged(), currentThemeChanged() and stylesheetChanged()
+	 * are not emitted for changes of a transaction - listeners that should
+	 * see these changes need to connect to changesCommitted().
+	 * Transactions may be nested - only the outermost commitTransaction()
+	 * applies the changes.
+	 */
+	void beginTransaction();
+
+	/**
+	 * Commits the current transaction.
+	 * The function performs one single updateStylesheet() pass for all
+	 * changes of the transaction and emits changesCommitted() once with all
+	 * changes. It does not emit currentStyleChanged(), currentThemeChanged()
+	 * or stylesheetChanged(). StylesheetChanged is only reported, if the CSS
+	 * has been regenerated.
+	 * Returns false, if the update failed or if no transaction is active.
+	 */
+	bool commitTransaction();
+
+	/**
+	 * Returns true, if a transaction is active
+	 */
+	bool isTransactionActive() const;
+
+	/**
+	 * Starts the live preview mode for interactive editing of theme
+	 * variables - e.g. while the user drags a color picker.
+	 * \see setLivePreviewVariable()
+	 */
+	void beginLivePreview();
+
+	/**
+	 * Sets a theme variable in live preview mode. The function may be called
+	 * at a high rate. The changes are coalesced and applied at most once
+	 * per frame. Each frame only updates the application palette and the
+	 * theme aware icons. The stylesheet is regenerated in memory and
+	 * stylesheetChanged() is emitted, if no variable has been set for
+	 * 200 ms. Nothing is written to disk in live preview mode - so the
+	 * generated SVG resources keep their colors until the preview is
+	 * committed. Starts the live preview mode, if it is not active.
+	 */
+	void setLivePreviewVariable(const QString& VariableId, const QString& Value);
+
+	/**
+	 * Leaves the live preview mode and applies all previewed variables via
+	 * updateStylesheet(). This generates the resources and writes the
+	 * stylesheet to the output folder.
+	 */
+	bool commitLivePreview();
+
+	/**
+	 * Leaves the live preview mode and restores the theme variables that
+	 * were set when the preview started
+	 */
+	void cancelLivePreview();
+
+	/**
+	 * Returns true, if the live preview mode is active
+	 */
+	bool isLivePreviewActive() const;
+
+	/**
+	 * Sets a style that has been compiled into the application by the
+	 * acss_stylec tool. The style is loaded from the compiled tables without
+	 * accessing any style files and without parsing JSON, XML or the CSS
+	 * template. The Style data must stay valid while it is in use.
+	 * The generated output files are still written to outputDirPath().
+	 */
+	bool setCurrentStyle(const CompiledStyle& Style);
+
+	/**
+	 * Returns true, if the current style is a compiled style
+	 */
+	bool isCompiledStyle() const;
+
+	/**
+	 * Writes C++ source code for the current style into the given device.
+	 * The source defines an acss::CompiledStyle with the given Identifier
+	 * that contains the parsed style json file, all themes, the tokenized
+	 * CSS template, the SVG resource templates and optionally the fonts.
+	 * The current style needs to be loaded from the styles dir.
+	 * This function is used by the acss_stylec tool.
+	 */
+	bool compileCurrentStyle(QIODevice& Device, const QString& Identifier,
+		bool EmbedFonts = true);
+
+	/**
+	 * Writes a C++ header with typed ids for the style variables and the
+	 * colors of all themes of the current style into the given device. The
+	 * header defines the enum eVariable, the name table and the function
+	 * registerVariableIds() in the given namespace.
+	 * The current style needs to be loaded from the styles dir.
+	 * This function is used by the acss_stylec tool.
+	 */
+	bool compileThemeVariableIds(QIODevice& Device, const QString& Namespace);
+
+	/**
+	 * Returns the memory that is held by this object, its caches and by the
+	 * theme aware icons loaded via loadThemeAwareSvgIcon(). Use it to check
+	 * long running applications for growing caches or for duplicated icons
+	 * that should be loaded once and shared.
+	 */
+	MemoryUsage memoryUsage() const;
+
 public slots:
 	/**
 	 * Sets the theme to use.
@@ -282,6 +844,10 @@ public slots:
 	 * (updateApplicationPaletteColors()), generates the theme SVG rseouces
 	 * (generateResources()) and then generates the stylesheet if it has a
 	 * template file.
+	 * The function tracks the changes since the last successful call. Each
+	 * stage only runs, if its inputs (style, output dir or the variables
+	 * that it uses) changed. If nothing changed, the function returns
+	 * true without emitting stylesheetChanged().
 	 * If you have split your stylesheet into several pieces or if your would
 	 * like to separate the update of the resources and the generation of
 	 * the stylehseets, then you should not use this function. Instead, call
@@ -307,6 +873,10 @@ public slots:
 	 * variables and if you would like to recreate the svg resources of this
 	 * style.If you call updateStylesheet(), then this function will be
 	 * called automatically
+	 * In shared output cache mode, this function only generates the
+	 * resources, if the cache entry has not been published yet. The entry
+	 * is published by updateStylesheet() after the stylesheet has been
+	 * written.
 	 */
 	bool generateResources();
 
@@ -315,28 +885,43 @@ public slots:
 	 * This function is called automatically if updateStylesheet() is called.
 	 * The function creates a palette with theme colors via generateThemePalette()
 	 * and then assigns the platte to the application object.
+	 * The palette is only assigned, if it differs from the current application
+	 * palette. Use changedPaletteRoles() to get the changed color roles.
 	 */
 	void updateApplicationPaletteColors();
 
 
 signals:
 	/**
-	 * This signal is emitted if the selected style changed
+	 * This signal is emitted if the selected style changed. It is not
+	 * emitted for changes of a transaction - see changesCommitted().
 	 */
 	void currentStyleChanged(const QString& Style);
 
 	/**
-	 * This signal is emitted, if the selected theme in a style changed
+	 * This signal is emitted, if the selected theme in a style changed. It
+	 * is not emitted for changes of a transaction - see changesCommitted().
 	 */
 	void currentThemeChanged(const QString& Theme);
 
 	/**
 	 * This signal is emitted if the stylesheet changed.
 	 * The stylesheed changes if the style changes, the theme changes or if a
-	 * style variable changed an the user requested a styleheet update
+	 * style variable changed an the user requested a styleheet update.
+	 * It is not emitted for changes of a transaction - see
+	 * changesCommitted().
 	 */
 	void stylesheetChanged();
+
+	/**
+	 * This signal is emitted once by commitTransaction() with all changes
+	 * of the committed transaction. It replaces currentStyleChanged(),
+	 * currentThemeChanged() and stylesheetChanged() for transactions.
+	 */
+	void changesCommitted(acss::QtAdvancedStylesheet::ChangeFlags Changes);
 }; // class StyleManager
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(QtAdvancedStylesheet::ChangeFlags)
 }
  // namespace namespace_name
 //-----------------------------------------------------------------------------
@@ -0,0 +1,498 @@
+/*******************************************************************************
+** Qt Advanced Stylesheets
+** Copyright (C) 2022 Uwe Kindler
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+
+//============================================================================
+/// \file   SharedIconCache.cpp
+/// \author Uwe Kindler
+/// \date   19.10.2026
+/// \brief  Implementation of CSharedIconCache class
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include "SharedIconCache.h"
+
+#include <QCryptographicHash>
+#include <QSharedMemory>
+
+#include <cstring>
+#include <limits>
+
+
+namespace acss
+{
+static const quint32 SharedIconCacheMagic = 0x41435349;
+static const quint32 SharedIconCacheVersion = 3;
+
+/**
+ * Header at the start of the shared memory segment. The header is followed
+ * by the slot table and the image data. If the cache is full, a new epoch
+ * clears the slot table and the image data.
+ */
+struct SharedIconCacheHeader
+{
+	quint32 Magic;
+	quint32 Version;
+	quint32 SlotCount;
+	quint32 EntryCount;
+	quint64 DataOffset;
+	quint64 DataSize;///< size of the image data
+	quint64 DataUsed;///< used bytes of the image data
+	quint32 Epoch;
+	quint32 Reserved;
+};
+
+/**
+ * Entry of the open addressing hash table
+ */
+struct SharedIconCacheSlot
+{
+	quint64 Key[2];
+	quint64 Offset;///< offset of the image data from the start of the segment
+	qint32 Width;
+	qint32 Height;
+	qint32 BytesPerLine;
+	qint32 Used;
+};
+
+
+/**
+ * Rounds the given size up to a multiple of 16 bytes
+ */
+static quint64 align16(quint64 Size)
+{
+	return (Size + 15) & ~quint64(15);
+}
+
+
+/**
+ * Private data class of CSharedIconCache class (pimpl)
+ */
+struct SharedIconCachePrivate
+{
+	CSharedIconCache *_this;
+	QSharedMemory Memory;
+	QString ErrorString;
+	int Hits = 0;
+	int Misses = 0;
+	int FailedInserts = 0;
+	int Resets = 0;
+
+	/**
+	 * Private data constructor
+	 */
+	SharedIconCachePrivate(CSharedIconCache *_public);
+
+	/**
+	 * Creates or attaches the shared memory segment
+	 */
+	bool attach(qint64 SizeBytes);
+
+	/**
+	 * Initializes the header and the slot table, if no other process did
+	 * it already. The shared memory needs to be locked.
+	 */
+	bool initialize();
+
+	/**
+	 * Returns true, if the header fields are consistent with the segment
+	 * size. Other processes write the segment, so its content is checked
+	 * before it is used. The shared memory needs to be locked.
+	 */
+	bool isValid() const;
+
+	/**
+	 * Clears the slot table and starts a new epoch in the other half of the
+	 * image data. The shared memory needs to be locked.
+	 */
+	void reset();
+
+	/**
+	 * Returns the segment header
+	 */
+	SharedIconCacheHeader* header() const
+	{
+		return static_cast<SharedIconCacheHeader*>(const_cast<void*>(Memory.constData()));
+	}
+
+	/**
+	 * Returns the slot table
+	 */
+	SharedIconCacheSlot* slotTable() const
+	{
+		return reinterpret_cast<SharedIconCacheSlot*>(header() + 1);
+	}
+
+	/**
+	 * Returns the index of the slot with the given key or of the empty slot
+	 * for the key. Returns -1, if the table is full. The shared memory needs
+	 * to be locked.
+	 */
+	int findSlot(const quint64* Key) const;
+
+	/**
+	 * Returns an image that uses the data of the given slot or a null image,
+	 * if the slot refers to data outside of the segment
+	 */
+	QImage image(const SharedIconCacheSlot& Slot) const;
+};// struct SharedIconCachePrivate
+
+
+//============================================================================
+SharedIconCachePrivate::SharedIconCachePrivate(CSharedIconCache *_public) :
+	_this(_public)
+{
+
+}
+
+
+//============================================================================
+bool SharedIconCachePrivate::attach(qint64 SizeBytes)
+{
+	// QSharedMemory::create() takes an int in Qt 5
+	using tSize = decltype(Memory.size());
+	if (SizeBytes <= qint64(sizeof(SharedIconCacheHeader))
+	 || SizeBytes > qint64(std::numeric_limits<tSize>::max()))
+	{
+		ErrorString = QString("Invalid shared icon cache size %1").arg(SizeBytes);
+		return false;
+	}
+
+	// The last process may detach and destroy the segment between our
+	// create() and attach() calls - so we try a second time
+	for (int i = 0; i < 2; ++i)
+	{
+		if (Memory.create(tSize(SizeBytes)) || Memory.attach())
+		{
+			break;
+		}
+	}
+	if (!Memory.isAttached())
+	{
+		ErrorString = Memory.errorString();
+		return false;
+	}
+
+	if (!Memory.lock())
+	{
+		ErrorString = Memory.errorString();
+		Memory.detach();
+		return false;
+	}
+	const bool Result = initialize();
+	Memory.unlock();
+	if (!Result)
+	{
+		Memory.detach();
+	}
+	return Result;
+}
+
+
+//============================================================================
+bool SharedIconCachePrivate::initialize()
+{
+	auto Header = header();
+	if (Header->Magic == SharedIconCacheMagic)
+	{
+		if (Header->Version != SharedIconCacheVersion)
+		{
+			ErrorString = "Shared icon cache " + Memory.key() + " has an incompatible version";
+			return false;
+		}
+		if (!isValid())
+		{
+			ErrorString = "Shared icon cache " + Memory.key() + " is corrupted";
+			return false;
+		}
+		return true;
+	}
+
+	// New segments are zero initialized. An average icon pixmap of 32 x 32
+	// pixels needs 4 KiB.
+	const quint64 Size = quint64(Memory.size());
+	const quint32 SlotCount = quint32(qMax<quint64>(64, Size / 4096));
+	const quint64 DataOffset = align16(sizeof(SharedIconCacheHeader)
+		+ SlotCount * sizeof(SharedIconCacheSlot));
+	if (DataOffset >= Size)
+	{
+		ErrorString = "Shared icon cache " + Memory.key() + " is too small";
+		return false;
+	}
+
+	memset(slotTable(), 0, SlotCount * sizeof(SharedIconCacheSlot));
+	Header->Version = SharedIconCacheVersion;
+	Header->SlotCount = SlotCount;
+	Header->EntryCount = 0;
+	Header->DataOffset = DataOffset;
+	Header->DataSize = (Size - DataOffset) & ~quint64(15);
+	Header->DataUsed = 0;
+	Header->Epoch = 0;
+	Header->Magic = SharedIconCacheMagic;
+	return true;
+}
+
+
+//============================================================================
+bool SharedIconCachePrivate::isValid() const
+{
+	const auto Header = header();
+	const quint64 Size = quint64(Memory.size());
+	return Header->Magic == SharedIconCacheMagic
+		&& Header->Version == SharedIconCacheVersion
+		&& Header->SlotCount > 0
+		&& Header->SlotCount <= Size / sizeof(SharedIconCacheSlot)
+		&& Header->DataOffset >= sizeof(SharedIconCacheHeader)
+			+ quint64(Header->SlotCount) * sizeof(SharedIconCacheSlot)
+		&& Header->DataOffset <= Size
+		&& Header->DataSize <= Size - Header->DataOffset
+		&& Header->DataUsed <= Header->DataSize;
+}
+
+
+//============================================================================
+void SharedIconCachePrivate::reset()
+{
+	auto Header = header();
+	memset(slotTable(), 0, Header->SlotCount * sizeof(SharedIconCacheSlot));
+	Header->EntryCount = 0;
+	Header->DataUsed = 0;
+	Header->Epoch++;
+	Resets++;
+}
+
+
+//============================================================================
+int SharedIconCachePrivate::findSlot(const quint64* Key) const
+{
+	const auto SlotCount = header()->SlotCount;
+	const auto Slots = slotTable();
+	for (quint32 i = 0, Index = Key[0] % SlotCount; i < SlotCount;
+		++i, Index = (Index + 1) % SlotCount)
+	{
+		const auto& Slot = Slots[Index];
+		if (!Slot.Used || (Slot.Key[0] == Key[0] && Slot.Key[1] == Key[1]))
+		{
+			return int(Index);
+		}
+	}
+	return -1;
+}
+
+
+//============================================================================
+QImage SharedIconCachePrivate::image(const SharedIconCacheSlot& Slot) const
+{
+	const auto Header = header();
+	if (Slot.Width <= 0 || Slot.Height <= 0
+	 || Slot.BytesPerLine < qint64(Slot.Width) * 4
+	 || Slot.Offset < Header->DataOffset
+	 || Slot.Offset > quint64(Memory.size())
+	 || quint64(Slot.BytesPerLine) * quint64(Slot.Height) > quint64(Memory.size()) - Slot.Offset)
+	{
+		return QImage();
+	}
+
+	// Other processes may overwrite the data as soon as the segment is
+	// unlocked - so the image gets its own copy of the pixel data
+	const auto Data = static_cast<const uchar*>(Memory.constData()) + Slot.Offset;
+	return QImage(Data, Slot.Width, Slot.Height, Slot.BytesPerLine,
+		QImage::Format_ARGB32_Premultiplied).copy();
+}
+
+
+//============================================================================
+CSharedIconCache::CSharedIconCache(const QString& Key, qint64 SizeBytes) :
+	d(new SharedIconCachePrivate(this))
+{
+	d->Memory.setKey(Key);
+	d->attach(SizeBytes);
+}
+
+
+//============================================================================
+CSharedIconCache::~CSharedIconCache()
+{
+	delete d;
+}
+
+
+//============================================================================
+bool CSharedIconCache::isAttached() const
+{
+	return d->Memory.isAttached();
+}
+
+
+//============================================================================
+QString CSharedIconCache::errorString() const
+{
+	return d->ErrorString;
+}
+
+
+//============================================================================
+QString CSharedIconCache::key() const
+{
+	return d->Memory.key();
+}
+
+
+//============================================================================
+QByteArray CSharedIconCache::entryKey(const QByteArray& SvgContent,
+	const QSize& PixelSize, qreal Scale, int Mode)
+{
+	const qint32 Parameters[4] = {PixelSize.width(), PixelSize.height(),
+		qRound(Scale * 100), Mode};
+	QCryptographicHash Hash(QCryptographicHash::Md5);
+	Hash.addData(SvgContent);
+	Hash.addData(QByteArray::fromRawData(reinterpret_cast<const char*>(Parameters),
+		sizeof(Parameters)));
+	return Hash.result();
+}
+
+
+//============================================================================
+QImage CSharedIconCache::find(const QByteArray& EntryKey)
+{
+	if (!isAttached() || EntryKey.size() != 2 * sizeof(quint64))
+	{
+		return QImage();
+	}
+
+	quint64 Key[2];
+	memcpy(Key, EntryKey.constData(), sizeof(Key));
+	QImage Result;
+	if (!d->Memory.lock())
+	{
+		d->ErrorString = d->Memory.errorString();
+		d->Misses++;
+		return QImage();
+	}
+	const int Index = d->isValid() ? d->findSlot(Key) : -1;
+	if (Index >= 0 && d->slotTable()[Index].Used)
+	{
+		Result = d->image(d->slotTable()[Index]);
+	}
+	d->Memory.unlock();
+	Result.isNull() ? d->Misses++ : d->Hits++;
+	return Result;
+}
+
+
+//============================================================================
+QImage CSharedIconCache::insert(const QByteArray& EntryKey, const QImage& Image)
+{
+	if (!isAttached() || EntryKey.size() != 2 * sizeof(quint64) || Image.isNull())
+	{
+		return QImage();
+	}
+
+	const auto Source = Image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+	const quint64 Bytes = quint64(Source.bytesPerLine()) * quint64(Source.height());
+	quint64 Key[2];
+	memcpy(Key, EntryKey.constData(), sizeof(Key));
+	QImage Result;
+	if (!d->Memory.lock())
+	{
+		d->ErrorString = d->Memory.errorString();
+		d->FailedInserts++;
+		return QImage();
+	}
+	auto Header = d->header();
+	const bool Valid = d->isValid();
+	int Index = Valid ? d->findSlot(Key) : -1;
+	auto Slot = (Index >= 0) ? &d->slotTable()[Index] : nullptr;
+	// The hash table is not filled completely to keep the probe sequences
+	// short. If the cache is full, a new epoch starts - images that do not
+	// fit into the empty cache are not cached.
+	auto isFull = [&]()
+	{
+		return !Slot || Header->EntryCount >= Header->SlotCount / 4 * 3
+			|| Header->DataUsed + align16(Bytes) > Header->DataSize;
+	};
+	if (Valid && !(Slot && Slot->Used) && isFull() && align16(Bytes) <= Header->DataSize)
+	{
+		d->reset();
+		Index = d->findSlot(Key);
+		Slot = (Index >= 0) ? &d->slotTable()[Index] : nullptr;
+	}
+
+	if (Slot && Slot->Used)
+	{
+		Result = d->image(*Slot);
+	}
+	else if (Valid && !isFull())
+	{
+		const quint64 Offset = Header->DataOffset + Header->DataUsed;
+		memcpy(static_cast<char*>(d->Memory.data()) + Offset, Source.constBits(), Bytes);
+		Slot->Key[0] = Key[0];
+		Slot->Key[1] = Key[1];
+		Slot->Offset = Offset;
+		Slot->Width = Source.width();
+		Slot->Height = Source.height();
+		Slot->BytesPerLine = int(Source.bytesPerLine());
+		Slot->Used = 1;
+		Header->EntryCount++;
+		Header->DataUsed += align16(Bytes);
+		Result = d->image(*Slot);
+	}
+	d->Memory.unlock();
+
+	if (Result.isNull())
+	{
+		d->FailedInserts++;
+	}
+	return Result;
+}
+
+
+//============================================================================
+CSharedIconCache::Statistics CSharedIconCache::statistics() const
+{
+	Statistics Result;
+	Result.Hits = d->Hits;
+	Result.Misses = d->Misses;
+	Result.FailedInserts = d->FailedInserts;
+	Result.Resets = d->Resets;
+	if (!isAttached())
+	{
+		return Result;
+	}
+
+	if (!d->Memory.lock())
+	{
+		d->ErrorString = d->Memory.errorString();
+		return Result;
+	}
+	const auto Header = d->header();
+	Result.Entries = int(Header->EntryCount);
+	Result.Capacity = int(Header->SlotCount / 4 * 3);
+	Result.UsedBytes = qint64(Header->DataUsed);
+	Result.DataBytes = qint64(Header->DataSize);
+	Result.Epoch = Header->Epoch;
+	d->Memory.unlock();
+	return Result;
+}
+
+} // namespace acss
+
+//---------------------------------------------------------------------------
+// EOF SharedIconCache.cpp
@@ -0,0 +1,142 @@
+#ifndef SharedIconCacheH
+#define SharedIconCacheH
+/*******************************************************************************
+** Qt Advanced Stylesheets
+** Copyright (C) 2022 Uwe Kindler
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+
+//============================================================================
+/// \file   SharedIconCache.h
+/// \author Uwe Kindler
+/// \date   19.10.2026
+/// \brief  Declaration of CSharedIconCache class
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include <QByteArray>
+#include <QImage>
+#include <QSize>
+#include <QString>
+
+#include "acss_globals.h"
+
+
+namespace acss
+{
+struct SharedIconCachePrivate;
+
+/**
+ * Cache for rendered icon images in shared memory.
+ * All processes that use the same key share one shared memory segment.
+ * An entry is identified by the hash of the recolored SVG content, the
+ * pixel size, the device pixel ratio and the icon mode, so processes with
+ * the same style and theme find the images the other processes rendered.
+ * The cache saves the rendering work - find() and insert() return a copy
+ * of the shared pixel data, so the returned images stay valid, if other
+ * processes change the cache. If the cache is full, insert() starts a new
+ * epoch and removes all entries.
+ * All header and entry fields are checked against the segment size before
+ * they are used. On Windows, the segment is released when the last
+ * process detaches. On Unix, Qt uses System V shared memory by default -
+ * a segment that was attached by crashed processes survives until it is
+ * removed manually (ipcrm) or the system reboots. The next process reuses
+ * the segment with its entries.
+ * The class is not thread safe - use it from the GUI thread only.
+ */
+class ACSS_EXPORT CSharedIconCache
+{
+private:
+	SharedIconCachePrivate* d; ///< private data (pimpl)
+	friend struct SharedIconCachePrivate;
+	Q_DISABLE_COPY(CSharedIconCache)
+
+public:
+	/**
+	 * Cache statistics. The hits and misses are counted per process.
+	 */
+	struct Statistics
+	{
+		int Entries = 0;
+		int Capacity = 0;///< maximum number of entries
+		qint64 UsedBytes = 0;///< bytes used by the image data
+		qint64 DataBytes = 0;///< bytes available for image data
+		int Hits = 0;
+		int Misses = 0;
+		int FailedInserts = 0;///< images that are too big for the cache
+		int Resets = 0;///< epochs started by this process because the cache was full
+		quint32 Epoch = 0;///< number of epochs of the segment
+	};
+
+	/**
+	 * Creates the shared memory segment with the given key and size or
+	 * attaches to an existing segment. Check isAttached() for success.
+	 * In Qt 5, the size is limited to 2 GiB.
+	 */
+	CSharedIconCache(const QString& Key, qint64 SizeBytes = 32 * 1024 * 1024);
+
+	/**
+	 * Virtual Destructor
+	 */
+	virtual ~CSharedIconCache();
+
+	/**
+	 * Returns true, if the shared memory segment is attached
+	 */
+	bool isAttached() const;
+
+	/**
+	 * Returns the error string of the last failed operation
+	 */
+	QString errorString() const;
+
+	/**
+	 * Returns the key of the shared memory segment
+	 */
+	QString key() const;
+
+	/**
+	 * Returns the entry key for the given SVG content, pixel size, device
+	 * pixel ratio and icon mode
+	 */
+	static QByteArray entryKey(const QByteArray& SvgContent, const QSize& PixelSize,
+		qreal Scale, int Mode);
+
+	/**
+	 * Returns the image with the given entry key or a null image, if the
+	 * entry does not exist or the segment could not be locked.
+	 */
+	QImage find(const QByteArray& EntryKey);
+
+	/**
+	 * Stores a copy of the given image with the given entry key and returns
+	 * a copy of the cached image. If another process inserted the entry in the
+	 * meantime, its image is returned. If the cache is full, a new epoch
+	 * starts. Returns a null image, if the image is too big for the cache.
+	 */
+	QImage insert(const QByteArray& EntryKey, const QImage& Image);
+
+	/**
+	 * Returns the statistics of the shared cache
+	 */
+	Statistics statistics() const;
+}; // class CSharedIconCache
+} // namespace acss
+
+//---------------------------------------------------------------------------
+#endif // SharedIconCacheH
@@ -0,0 +1,302 @@
+/*******************************************************************************
+** Qt Advanced Stylesheets
+** Copyright (C) 2022 Uwe Kindler
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+
+//============================================================================
+/// \file   StylePolishProfiler.cpp
+/// \author Uwe Kindler
+/// \date   19.10.2026
+/// \brief  Implementation of CStylePolishProfiler class
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include "StylePolishProfiler.h"
+#include "StylesheetAnalyzer.h"
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QMetaObject>
+#include <QPointer>
+#include <QStyle>
+#include <QTextStream>
+#include <QWidget>
+
+#include <algorithm>
+
+
+namespace acss
+{
+/**
+ * Private data class of CStylePolishProfiler class (pimpl)
+ */
+struct StylePolishProfilerPrivate
+{
+	CStylePolishProfiler *_this;
+	bool Active = false;
+	QHash<QString, CStylePolishProfiler::Statistics> ClassStatistics;
+	QHash<QString, CStylePolishProfiler::Statistics> ObjectStatistics;
+	QHash<QString, QStringList> ClassHierarchies;///< class and base class names per class
+	QVector<CStylesheetAnalyzer::Section> Sections;
+
+	/**
+	 * Private data constructor
+	 */
+	StylePolishProfilerPrivate(CStylePolishProfiler *_public);
+
+	/**
+	 * Records a measurement for the given widget
+	 */
+	void record(const QWidget* Widget, CStylePolishProfiler::eMeasurement Measurement,
+		qint64 Nanoseconds);
+};// struct StylePolishProfilerPrivate
+
+
+//============================================================================
+StylePolishProfilerPrivate::StylePolishProfilerPrivate(
+	CStylePolishProfiler *_public) :
+	_this(_public)
+{
+
+}
+
+
+//============================================================================
+void StylePolishProfilerPrivate::record(const QWidget* Widget,
+	CStylePolishProfiler::eMeasurement Measurement, qint64 Nanoseconds)
+{
+	const auto MetaObject = Widget->metaObject();
+	const QString ClassName = MetaObject->className();
+	if (!ClassHierarchies.contains(ClassName))
+	{
+		QStringList Hierarchy;
+		for (auto mo = MetaObject; mo; mo = mo->superClass())
+		{
+			Hierarchy.append(mo->className());
+		}
+		ClassHierarchies.insert(ClassName, Hierarchy);
+	}
+
+	auto& ClassStats = ClassStatistics[ClassName];
+	ClassStats.Count[Measurement]++;
+	ClassStats.Nanoseconds[Measurement] += Nanoseconds;
+	if (Widget->objectName().isEmpty())
+	{
+		return;
+	}
+
+	auto& ObjectStats = ObjectStatistics[ClassName + "#" + Widget->objectName()];
+	ObjectStats.Count[Measurement]++;
+	ObjectStats.Nanoseconds[Measurement] += Nanoseconds;
+}
+
+
+//============================================================================
+CStylePolishProfiler::CStylePolishProfiler(QObject* Parent) :
+	QObject(Parent),
+	d(new StylePolishProfilerPrivate(this))
+{
+
+}
+
+
+//============================================================================
+CStylePolishProfiler::~CStylePolishProfiler()
+{
+	stop();
+	delete d;
+}
+
+
+//============================================================================
+void CStylePolishProfiler::start()
+{
+	d->Active = true;
+}
+
+
+//============================================================================
+void CStylePolishProfiler::stop()
+{
+	d->Active = false;
+}
+
+
+//============================================================================
+bool CStylePolishProfiler::isActive() const
+{
+	return d->Active;
+}
+
+
+//============================================================================
+void CStylePolishProfiler::reset()
+{
+	d->ClassStatistics.clear();
+	d->ObjectStatistics.clear();
+}
+
+
+//============================================================================
+void CStylePolishProfiler::setStylesheet(const QString& Stylesheet)
+{
+	CStylesheetAnalyzer Analyzer;
+	d->Sections = Analyzer.analyze(Stylesheet).Sections;
+}
+
+
+//============================================================================
+void CStylePolishProfiler::measureRepolish(QWidget* Root)
+{
+	auto Widgets = Root->findChildren<QWidget*>();
+	Widgets.prepend(Root);
+	QElapsedTimer Timer;
+	for (auto Widget : Widgets)
+	{
+		auto Style = Widget->style();
+		Timer.start();
+		Style->unpolish(Widget);
+		Style->polish(Widget);
+		d->record(Widget, Repolish, Timer.nsecsElapsed());
+	}
+}
+
+
+//============================================================================
+QHash<QString, CStylePolishProfiler::Statistics> CStylePolishProfiler::classStatistics() const
+{
+	return d->ClassStatistics;
+}
+
+
+//============================================================================
+QHash<QString, CStylePolishProfiler::Statistics> CStylePolishProfiler::objectStatistics() const
+{
+	return d->ObjectStatistics;
+}
+
+
+//============================================================================
+QStringList CStylePolishProfiler::sectionsForClass(const QString& ClassName) const
+{
+	// Sections that target the class itself come before the sections that
+	// target its base classes
+	const auto Hierarchy = d->ClassHierarchies.value(ClassName, {ClassName});
+	QStringList Result;
+	for (const auto& Type : Hierarchy)
+	{
+		for (const auto& Section : d->Sections)
+		{
+			if (Section.SubjectTypes.contains(Type) && !Result.contains(Section.Name))
+			{
+				Result.append(Section.Name);
+			}
+		}
+	}
+	return Result;
+}
+
+
+//============================================================================
+QString CStylePolishProfiler::report(int MaxRows) const
+{
+	QString Result;
+	QTextStream s(&Result);
+	auto writeTable = [&](const QString& Title, const QHash<QString, Statistics>& Stats,
+		bool ShowSections)
+	{
+		auto Keys = Stats.keys();
+		std::sort(Keys.begin(), Keys.end(), [&Stats](const QString& a, const QString& b)
+		{
+			return Stats[a].totalNanoseconds() > Stats[b].totalNanoseconds();
+		});
+
+		s << QString("%1 %2 %3 %4 %5 %6 %7\n").arg(Title, -40).arg("count", 7)
+			.arg("polish", 9).arg("style", 9).arg("paint", 9).arg("repolish", 9)
+			.arg("total", 9);
+		for (int i = 0; i < Keys.size() && i < MaxRows; ++i)
+		{
+			const auto& Stat = Stats[Keys[i]];
+			int Count = 0;
+			for (int m = 0; m < MeasurementCount; ++m)
+			{
+				Count = qMax(Count, Stat.Count[m]);
+			}
+			s << QString("%1 %2 %3 %4 %5 %6 %7\n").arg(Keys[i], -40).arg(Count, 7)
+				.arg(Stat.Nanoseconds[PolishEvent] / 1e6, 9, 'f', 2)
+				.arg(Stat.Nanoseconds[StyleChangeEvent] / 1e6, 9, 'f', 2)
+				.arg(Stat.Nanoseconds[PaintEvent] / 1e6, 9, 'f', 2)
+				.arg(Stat.Nanoseconds[Repolish] / 1e6, 9, 'f', 2)
+				.arg(Stat.totalNanoseconds() / 1e6, 9, 'f', 2);
+			const auto Sections = ShowSections ? sectionsForClass(Keys[i]) : QStringList();
+			if (!Sections.isEmpty())
+			{
+				s << "    sections: " << Sections.mid(0, 5).join(", ") << "\n";
+			}
+		}
+		s << "\n";
+	};
+
+	s << "Widget polish profile - times in ms\n\n";
+	writeTable("widget class", d->ClassStatistics, true);
+	if (!d->ObjectStatistics.isEmpty())
+	{
+		writeTable("object", d->ObjectStatistics, false);
+	}
+	return Result;
+}
+
+
+//============================================================================
+bool CStylePolishProfiler::notify(QObject* Receiver, QEvent* Event,
+	const std::function<bool()>& Deliver)
+{
+	eMeasurement Measurement;
+	switch (Event->type())
+	{
+	case QEvent::Polish: Measurement = PolishEvent; break;
+	case QEvent::StyleChange: Measurement = StyleChangeEvent; break;
+	case QEvent::Paint: Measurement = PaintEvent; break;
+	default:
+		return Deliver();
+	}
+
+	if (!d->Active || !Receiver || !Receiver->isWidgetType())
+	{
+		return Deliver();
+	}
+
+	// The widget may be deleted while it processes the event, so the class
+	// and object name are recorded via a guarded pointer
+	QPointer<QWidget> Widget = static_cast<QWidget*>(Receiver);
+	QElapsedTimer Timer;
+	Timer.start();
+	const bool Result = Deliver();
+	const auto Nanoseconds = Timer.nsecsElapsed();
+	if (Widget)
+	{
+		d->record(Widget, Measurement, Nanoseconds);
+	}
+	return Result;
+}
+} // namespace acss
+
+//---------------------------------------------------------------------------
+// EOF StylePolishProfiler.cpp
@@ -0,0 +1,192 @@
+#ifndef StylePolishProfilerH
+#define StylePolishProfilerH
+/*******************************************************************************
+** Qt Advanced Stylesheets
+** Copyright (C) 2022 Uwe Kindler
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+
+//============================================================================
+/// \file   StylePolishProfiler.h
+/// \author Uwe Kindler
+/// \date   19.10.2026
+/// \brief  Declaration of CStylePolishProfiler class
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include <QObject>
+#include <QHash>
+#include <QStringList>
+
+#include <functional>
+
+#include "acss_globals.h"
+
+QT_FORWARD_DECLARE_CLASS(QWidget)
+QT_FORWARD_DECLARE_CLASS(QEvent)
+
+namespace acss
+{
+struct StylePolishProfilerPrivate;
+
+/**
+ * Opt-in profiler that measures the cost of the widget events that are
+ * affected by a stylesheet.
+ * The profiler measures the processing time of all Polish, StyleChange and
+ * Paint events of widgets. An event filter only sees an event before it is
+ * delivered, so the events are measured in the notify() function of the
+ * application - call notify() from the QApplication::notify() override of
+ * your application class. The profiler does not send any events on its
+ * own, so it does not change the event delivery it measures.
+ * The times are aggregated per widget class and per object name. If a
+ * stylesheet is assigned via setStylesheet(), the report links each widget
+ * class to the stylesheet sections whose selectors target the class or one
+ * of its base classes. Each comment with a name like "Basic widgets" starts
+ * a new section. Separator comments that only contain dashes are ignored.
+ * Because style polishing happens before the Polish event is sent,
+ * measureRepolish() can be used to measure the pure stylesheet polish
+ * cost of a widget tree.
+ */
+class ACSS_EXPORT CStylePolishProfiler : public QObject
+{
+	Q_OBJECT
+private:
+	StylePolishProfilerPrivate* d; ///< private data (pimpl)
+	friend struct StylePolishProfilerPrivate;
+
+public:
+	/**
+	 * The measured operations
+	 */
+	enum eMeasurement
+	{
+		PolishEvent,
+		StyleChangeEvent,
+		PaintEvent,
+		Repolish,///< measured by measureRepolish()
+		MeasurementCount
+	};
+
+	/**
+	 * Aggregated measurements of a widget class or object
+	 */
+	struct Statistics
+	{
+		int Count[MeasurementCount] = {0, 0, 0, 0};
+		qint64 Nanoseconds[MeasurementCount] = {0, 0, 0, 0};
+
+		/**
+		 * Returns the sum of all measurements in nanoseconds
+		 */
+		qint64 totalNanoseconds() const
+		{
+			qint64 Total = 0;
+			for (int i = 0; i < MeasurementCount; ++i)
+			{
+				Total += Nanoseconds[i];
+			}
+			return Total;
+		}
+	};
+
+	/**
+	 * Default Constructor
+	 */
+	CStylePolishProfiler(QObject* Parent = nullptr);
+
+	/**
+	 * Virtual Destructor
+	 */
+	virtual ~CStylePolishProfiler();
+
+	/**
+	 * Starts profiling
+	 */
+	void start();
+
+	/**
+	 * Stops profiling
+	 */
+	void stop();
+
+	/**
+	 * Returns true, if the profiler is active
+	 */
+	bool isActive() const;
+
+	/**
+	 * Clears all measurements
+	 */
+	void reset();
+
+	/**
+	 * Assigns the stylesheet that is used to link widget classes to
+	 * stylesheet sections. You can pass the generated stylesheet or the
+	 * CSS template.
+	 */
+	void setStylesheet(const QString& Stylesheet);
+
+	/**
+	 * Unpolishes and polishes the given widget and all its children with
+	 * their current style and records the time per widget
+	 */
+	void measureRepolish(QWidget* Root);
+
+	/**
+	 * Returns the measurements per widget class name
+	 */
+	QHash<QString, Statistics> classStatistics() const;
+
+	/**
+	 * Returns the measurements per object. The key is the class name and
+	 * the object name separated by "#". Objects without a name are not
+	 * included.
+	 */
+	QHash<QString, Statistics> objectStatistics() const;
+
+	/**
+	 * Returns the stylesheet sections with selectors that target the given
+	 * widget class. Sections that target the class directly come first,
+	 * followed by the sections that target its base classes.
+	 */
+	QStringList sectionsForClass(const QString& ClassName) const;
+
+	/**
+	 * Returns a text report with the most expensive widget classes and
+	 * objects and the linked stylesheet sections
+	 */
+	QString report(int MaxRows = 20) const;
+
+	/**
+	 * Delivers the event via the given Deliver function and measures the
+	 * delivery, if the profiler is active and if the event is a measured
+	 * event of a widget. Returns the result of Deliver.
+	 * \code
+	 * bool notify(QObject* Receiver, QEvent* Event) override
+	 * {
+	 *     return Profiler->notify(Receiver, Event,
+	 *         [&]() {return QApplication::notify(Receiver, Event);});
+	 * }
+	 * \endcode
+	 */
+	bool notify(QObject* Receiver, QEvent* Event, const std::function<bool()>& Deliver);
+}; // class CStylePolishProfiler
+} // namespace acss
+
+//---------------------------------------------------------------------------
+#endif // StylePolishProfilerH
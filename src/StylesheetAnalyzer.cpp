@@ -0,0 +1,364 @@
+/*******************************************************************************
+** Qt Advanced Stylesheets
+** Copyright (C) 2022 Uwe Kindler
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+
+//============================================================================
+/// \file   StylesheetAnalyzer.cpp
+/// \author Uwe Kindler
+/// \date   19.10.2026
+/// \brief  Implementation of CStylesheetAnalyzer class
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include "StylesheetAnalyzer.h"
+
+#include <QHash>
+#include <QRegularExpression>
+#include <QTextStream>
+
+#include <algorithm>
+
+
+namespace acss
+{
+/**
+ * Private data class of CStylesheetAnalyzer class (pimpl)
+ */
+struct StylesheetAnalyzerPrivate
+{
+	CStylesheetAnalyzer *_this;
+	CStylesheetAnalyzer::Statistics Statistics;
+	QSet<QString> Resources;
+	QHash<QString, QString> RuleBodies;///< first selector per declaration block
+
+	/**
+	 * Private data constructor
+	 */
+	StylesheetAnalyzerPrivate(CStylesheetAnalyzer *_public);
+
+	/**
+	 * Analyzes the selectors of a rule and adds them to the given section
+	 */
+	void analyzeSelectors(const QString& SelectorText, CStylesheetAnalyzer::Section& Section);
+
+	/**
+	 * Analyzes the declaration block of a rule
+	 */
+	void analyzeDeclarations(const QString& SelectorText, const QString& Body);
+};// struct StylesheetAnalyzerPrivate
+
+
+//============================================================================
+StylesheetAnalyzerPrivate::StylesheetAnalyzerPrivate(
+	CStylesheetAnalyzer *_public) :
+	_this(_public)
+{
+
+}
+
+
+//============================================================================
+void StylesheetAnalyzerPrivate::analyzeSelectors(const QString& SelectorText,
+	CStylesheetAnalyzer::Section& Section)
+{
+	static const QRegularExpression Attributes("\\[[^\\]]*\\]");
+	static const QRegularExpression ChildCombinator("\\s*>\\s*");
+	static const QRegularExpression Whitespace("\\s");
+	static const QRegularExpression Pseudo("(::?)(!?[A-Za-z][A-Za-z0-9-]*)");
+	const auto Selectors = SelectorText.split(',');
+	for (const auto& Selector : Selectors)
+	{
+		auto Simplified = Selector.simplified();
+		auto Type = CStylesheetAnalyzer::subjectType(Simplified);
+		if (Type.isEmpty())
+		{
+			continue;
+		}
+
+		Statistics.Selectors++;
+		Section.Selectors++;
+		Section.SubjectTypes.insert(Type);
+		if (Type == "*")
+		{
+			Statistics.UniversalSelectors++;
+			Statistics.Findings.append(QString("Universal selector \"%1\" in section "
+				"\"%2\" is matched against every widget").arg(Simplified, Section.Name));
+		}
+
+		// Attribute values may contain spaces and colons
+		auto Compounds = Simplified.remove(Attributes);
+		Compounds.replace(ChildCombinator, ">");
+		if (Compounds.contains(Whitespace))
+		{
+			Statistics.DescendantSelectors++;
+		}
+		if (Compounds.contains('>'))
+		{
+			Statistics.ChildSelectors++;
+		}
+
+		auto it = Pseudo.globalMatch(Compounds);
+		while (it.hasNext())
+		{
+			auto Match = it.next();
+			auto& Usage = (Match.captured(1).size() == 2) ? Statistics.SubControls
+				: Statistics.PseudoStates;
+			Usage[Match.captured(2)]++;
+		}
+	}
+}
+
+
+//============================================================================
+void StylesheetAnalyzerPrivate::analyzeDeclarations(const QString& SelectorText,
+	const QString& Body)
+{
+	static const QRegularExpression Comments("/\\*.*?\\*/",
+		QRegularExpression::DotMatchesEverythingOption);
+	static const QRegularExpression Url("url\\(\\s*['\"]?([^'\")]+)['\"]?\\s*\\)");
+	const auto RuleName = SelectorText.simplified();
+	auto Declarations = QString(Body).remove(Comments).split(';');
+	QStringList NormalizedDeclarations;
+	QSet<QString> Properties;
+	for (const auto& Declaration : Declarations)
+	{
+		auto Normalized = Declaration.simplified();
+		if (Normalized.isEmpty())
+		{
+			continue;
+		}
+
+		Statistics.Declarations++;
+		NormalizedDeclarations.append(Normalized);
+		auto Property = Normalized.section(':', 0, 0).trimmed().toLower();
+		if (Properties.contains(Property))
+		{
+			Statistics.DuplicatedDeclarations++;
+			Statistics.Findings.append(QString("Property \"%1\" is declared more than "
+				"once in rule \"%2\"").arg(Property, RuleName));
+		}
+		Properties.insert(Property);
+
+		auto it = Url.globalMatch(Normalized);
+		while (it.hasNext())
+		{
+			Resources.insert(it.next().captured(1).trimmed());
+		}
+	}
+
+	if (NormalizedDeclarations.isEmpty())
+	{
+		return;
+	}
+
+	// Rules with the same declarations could be merged into one rule with
+	// a selector list
+	const auto Key = NormalizedDeclarations.join(';');
+	auto it = RuleBodies.constFind(Key);
+	if (it == RuleBodies.constEnd())
+	{
+		RuleBodies.insert(Key, RuleName);
+		return;
+	}
+
+	Statistics.DuplicatedRuleBodies++;
+	Statistics.Findings.append(QString("Rule \"%1\" repeats the declarations of rule "
+		"\"%2\"").arg(RuleName, it.value()));
+}
+
+
+//============================================================================
+CStylesheetAnalyzer::CStylesheetAnalyzer() :
+	d(new StylesheetAnalyzerPrivate(this))
+{
+
+}
+
+
+//============================================================================
+CStylesheetAnalyzer::~CStylesheetAnalyzer()
+{
+	delete d;
+}
+
+
+//============================================================================
+QString CStylesheetAnalyzer::subjectType(const QString& Selector)
+{
+	static const QRegularExpression LastCompound("([^\\s>+~]+)\\s*$");
+	static const QRegularExpression TypeName("^\\.?([A-Za-z_][A-Za-z0-9_-]*)");
+	auto Compound = LastCompound.match(Selector);
+	if (!Compound.hasMatch())
+	{
+		return QString();
+	}
+
+	auto Match = TypeName.match(Compound.captured(1));
+	return Match.hasMatch() ? Match.captured(1).replace("--", "::") : QString("*");
+}
+
+
+//============================================================================
+const CStylesheetAnalyzer::Statistics& CStylesheetAnalyzer::analyze(const QString& Stylesheet)
+{
+	static const QRegularExpression Letters("[A-Za-z]");
+	d->Statistics = Statistics();
+	d->Resources.clear();
+	d->RuleBodies.clear();
+	d->Statistics.Bytes = Stylesheet.toUtf8().size();
+
+	// Each named comment starts a new section. The text up to the next
+	// named comment belongs to the section.
+	QVector<Section> Sections;
+	QVector<int> SectionStarts;
+	Sections.append(Section());
+	Sections.last().Name = "(no section)";
+	SectionStarts.append(0);
+	int SelectorStart = 0;
+	int i = 0;
+	while (i < Stylesheet.size())
+	{
+		if (Stylesheet.at(i) == '/' && (i + 1) < Stylesheet.size()
+			&& Stylesheet.at(i + 1) == '*')
+		{
+			int End = Stylesheet.indexOf("*/", i + 2);
+			End = (End < 0) ? Stylesheet.size() : End;
+			auto Comment = Stylesheet.mid(i + 2, End - i - 2).trimmed();
+			// Separator comments like "-----" do not start a new section
+			if (Comment.contains(Letters) && Comment != Sections.last().Name)
+			{
+				Sections.append(Section());
+				Sections.last().Name = Comment;
+				SectionStarts.append(i);
+			}
+			i = SelectorStart = End + 2;
+			continue;
+		}
+
+		if (Stylesheet.at(i) != '{')
+		{
+			++i;
+			continue;
+		}
+
+		int End = Stylesheet.indexOf('}', i);
+		End = (End < 0) ? Stylesheet.size() : End;
+		const auto SelectorText = Stylesheet.mid(SelectorStart, i - SelectorStart);
+		d->Statistics.Rules++;
+		Sections.last().Rules++;
+		d->analyzeSelectors(SelectorText, Sections.last());
+		d->analyzeDeclarations(SelectorText, Stylesheet.mid(i + 1, End - i - 1));
+		i = SelectorStart = End + 1;
+	}
+
+	SectionStarts.append(Stylesheet.size());
+	for (int s = 0; s < Sections.size(); ++s)
+	{
+		// Sections without rules, like a license header, are not reported
+		if (!Sections[s].Rules)
+		{
+			continue;
+		}
+		Sections[s].Bytes = Stylesheet.mid(SectionStarts[s],
+			SectionStarts[s + 1] - SectionStarts[s]).toUtf8().size();
+		d->Statistics.Sections.append(Sections[s]);
+	}
+
+	d->Statistics.Resources = d->Resources.values();
+	std::sort(d->Statistics.Resources.begin(), d->Statistics.Resources.end());
+	return d->Statistics;
+}
+
+
+//============================================================================
+const CStylesheetAnalyzer::Statistics& CStylesheetAnalyzer::statistics() const
+{
+	return d->Statistics;
+}
+
+
+//============================================================================
+QString CStylesheetAnalyzer::report(int MaxRows) const
+{
+	const auto& Stats = d->Statistics;
+	QString Result;
+	QTextStream s(&Result);
+	auto writeUsage = [&](const QString& Title, const QMap<QString, int>& Usage)
+	{
+		auto Keys = Usage.keys();
+		std::stable_sort(Keys.begin(), Keys.end(), [&Usage](const QString& a, const QString& b)
+		{
+			return Usage[a] > Usage[b];
+		});
+		s << QString("%1 %2\n").arg(Title, -40).arg("count", 7);
+		for (int i = 0; i < Keys.size() && i < MaxRows; ++i)
+		{
+			s << QString("%1 %2\n").arg(Keys[i], -40).arg(Usage[Keys[i]], 7);
+		}
+		s << "\n";
+	};
+
+	s << "Stylesheet analysis\n\n";
+	s << QString("%1 %2\n").arg("bytes", -40).arg(Stats.Bytes, 7);
+	s << QString("%1 %2\n").arg("rules", -40).arg(Stats.Rules, 7);
+	s << QString("%1 %2\n").arg("selectors", -40).arg(Stats.Selectors, 7);
+	s << QString("%1 %2\n").arg("universal selectors", -40).arg(Stats.UniversalSelectors, 7);
+	s << QString("%1 %2\n").arg("descendant selectors", -40).arg(Stats.DescendantSelectors, 7);
+	s << QString("%1 %2\n").arg("child selectors", -40).arg(Stats.ChildSelectors, 7);
+	s << QString("%1 %2\n").arg("declarations", -40).arg(Stats.Declarations, 7);
+	s << QString("%1 %2\n").arg("duplicated declarations", -40).arg(Stats.DuplicatedDeclarations, 7);
+	s << QString("%1 %2\n").arg("duplicated rule bodies", -40).arg(Stats.DuplicatedRuleBodies, 7);
+	s << QString("%1 %2\n\n").arg("url() resources", -40).arg(Stats.Resources.size(), 7);
+
+	auto Sections = Stats.Sections;
+	std::stable_sort(Sections.begin(), Sections.end(), [](const Section& a, const Section& b)
+	{
+		return a.Bytes > b.Bytes;
+	});
+	s << QString("%1 %2 %3 %4\n").arg("section", -40).arg("bytes", 7).arg("rules", 7)
+		.arg("selectors", 9);
+	for (int i = 0; i < Sections.size() && i < MaxRows; ++i)
+	{
+		s << QString("%1 %2 %3 %4\n").arg(Sections[i].Name.left(40), -40)
+			.arg(Sections[i].Bytes, 7).arg(Sections[i].Rules, 7).arg(Sections[i].Selectors, 9);
+	}
+	s << "\n";
+
+	writeUsage("pseudo state", Stats.PseudoStates);
+	writeUsage("sub-control", Stats.SubControls);
+
+	if (!Stats.Findings.isEmpty())
+	{
+		s << "Findings\n";
+		for (int i = 0; i < Stats.Findings.size() && i < MaxRows; ++i)
+		{
+			s << "  " << Stats.Findings[i] << "\n";
+		}
+		if (Stats.Findings.size() > MaxRows)
+		{
+			s << "  ... " << (Stats.Findings.size() - MaxRows) << " more\n";
+		}
+	}
+	return Result;
+}
+} // namespace acss
+
+//---------------------------------------------------------------------------
+// EOF StylesheetAnalyzer.cpp
@@ -0,0 +1,133 @@
+#ifndef StylesheetAnalyzerH
+#define StylesheetAnalyzerH
+/*******************************************************************************
+** Qt Advanced Stylesheets
+** Copyright (C) 2022 Uwe Kindler
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+
+//============================================================================
+/// \file   StylesheetAnalyzer.h
+/// \author Uwe Kindler
+/// \date   19.10.2026
+/// \brief  Declaration of CStylesheetAnalyzer class
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include <QMap>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "acss_globals.h"
+
+
+namespace acss
+{
+struct StylesheetAnalyzerPrivate;
+
+/**
+ * Collects statistics about the complexity of a stylesheet.
+ * Qt matches the selectors of all rules against each widget that is
+ * polished. Universal selectors like "*" and descendant selectors are
+ * matched against every widget and its parents, so the analyzer counts
+ * them and reports the patterns that are expensive for the style engine.
+ * Each comment with a name like "Basic widgets" starts a new section.
+ * Separator comments that only contain dashes are ignored. You can analyze
+ * the generated stylesheet or the CSS template.
+ */
+class ACSS_EXPORT CStylesheetAnalyzer
+{
+private:
+	StylesheetAnalyzerPrivate* d; ///< private data (pimpl)
+	friend struct StylesheetAnalyzerPrivate;
+	Q_DISABLE_COPY(CStylesheetAnalyzer)
+
+public:
+	/**
+	 * A stylesheet section
+	 */
+	struct Section
+	{
+		QString Name;
+		int Bytes = 0;///< UTF-8 size of the section including comments
+		int Rules = 0;
+		int Selectors = 0;
+		QSet<QString> SubjectTypes;///< type of the subject of each selector
+	};
+
+	/**
+	 * The analysis results
+	 */
+	struct Statistics
+	{
+		int Bytes = 0;///< UTF-8 size of the stylesheet
+		int Rules = 0;
+		int Selectors = 0;
+		int UniversalSelectors = 0;///< selectors whose subject has no type
+		int DescendantSelectors = 0;
+		int ChildSelectors = 0;
+		int Declarations = 0;
+		int DuplicatedDeclarations = 0;///< properties declared again in the same rule
+		int DuplicatedRuleBodies = 0;///< rules with the declarations of a previous rule
+		QMap<QString, int> PseudoStates;///< usage count per pseudo state
+		QMap<QString, int> SubControls;///< usage count per sub-control
+		QStringList Resources;///< distinct url() resources
+		QVector<Section> Sections;
+		QStringList Findings;///< expensive patterns
+	};
+
+	/**
+	 * Default Constructor
+	 */
+	CStylesheetAnalyzer();
+
+	/**
+	 * Virtual Destructor
+	 */
+	virtual ~CStylesheetAnalyzer();
+
+	/**
+	 * Analyzes the given stylesheet and replaces the statistics of a
+	 * previous analysis
+	 */
+	const Statistics& analyze(const QString& Stylesheet);
+
+	/**
+	 * Returns the statistics of the last analysis
+	 */
+	const Statistics& statistics() const;
+
+	/**
+	 * Returns a text report of the last analysis. Tables are limited to the
+	 * given number of rows.
+	 */
+	QString report(int MaxRows = 10) const;
+
+	/**
+	 * Returns the type of the subject of the given selector - that is the
+	 * type of its last compound selector. Returns "*" for selectors without
+	 * type and an empty string for an empty selector.
+	 */
+	static QString subjectType(const QString& Selector);
+}; // class CStylesheetAnalyzer
+} // namespace acss
+
+//---------------------------------------------------------------------------
+#endif // StylesheetAnalyzerH
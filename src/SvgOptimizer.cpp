@@ -0,0 +1,451 @@
+/*******************************************************************************
+** Qt Advanced Stylesheets
+** Copyright (C) 2022 Uwe Kindler
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+
+//============================================================================
+/// \file   SvgOptimizer.cpp
+/// \author Uwe Kindler
+/// \date   19.10.2026
+/// \brief  Implementation of CSvgOptimizer class
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include "SvgOptimizer.h"
+
+#include <QRegularExpression>
+#include <QSet>
+#include <QVector>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+
+namespace acss
+{
+/**
+ * Namespace prefixes of editor specific elements and attributes
+ */
+static const char* const EditorPrefixes[] = {"sodipodi", "inkscape", "rdf", "cc",
+	"dc", "sketch", "serif"};
+
+/**
+ * Attributes with coordinates and lengths that may be rounded. Style and
+ * color attributes are never changed.
+ */
+static const char* const GeometryAttributes[] = {"d", "points", "transform",
+	"x", "y", "x1", "y1", "x2", "y2", "cx", "cy", "r", "rx", "ry", "fx", "fy",
+	"width", "height", "stroke-width"};
+
+
+/**
+ * An element of the document that is currently written
+ */
+struct OpenElement
+{
+	bool Written;///< false for skipped start tags of collapsed groups
+	bool IsDefs;
+	bool IsText;
+};
+
+
+/**
+ * Private data class of CSvgOptimizer class (pimpl)
+ */
+struct SvgOptimizerPrivate
+{
+	CSvgOptimizer *_this;
+	CSvgOptimizer::Options Options;
+	int Precision;
+	CSvgOptimizer::Statistics Statistics;
+
+	/**
+	 * Private data constructor
+	 */
+	SvgOptimizerPrivate(CSvgOptimizer *_public);
+
+	/**
+	 * Returns true, if the given qualified name is an editor specific name
+	 * like "sodipodi:namedview" or a declaration of an editor namespace
+	 */
+	static bool isEditorName(const QString& QualifiedName);
+
+	/**
+	 * Collects all ids of the given SVG that are referenced via href or
+	 * url(#id). Returns false, if the references can not be determined
+	 * reliably - e.g. if the document contains a style element.
+	 */
+	static bool collectReferences(const QByteArray& Svg, QSet<QString>& References);
+
+	/**
+	 * Rounds all decimal numbers in the given attribute value
+	 */
+	QString roundNumbers(const QString& Value) const;
+
+	/**
+	 * Writes the optimized document. Returns false on XML errors.
+	 */
+	bool writeOptimized(const QByteArray& Svg, QByteArray& Result) const;
+};// struct SvgOptimizerPrivate
+
+
+//============================================================================
+SvgOptimizerPrivate::SvgOptimizerPrivate(CSvgOptimizer *_public) :
+	_this(_public)
+{
+
+}
+
+
+//============================================================================
+bool SvgOptimizerPrivate::isEditorName(const QString& QualifiedName)
+{
+	const auto Prefix = QualifiedName.startsWith("xmlns:")
+		? QualifiedName.mid(6) : QualifiedName.section(':', 0, 0);
+	if (Prefix == QualifiedName)
+	{
+		return false;
+	}
+
+	for (auto EditorPrefix : EditorPrefixes)
+	{
+		if (Prefix == QLatin1String(EditorPrefix))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+//============================================================================
+bool SvgOptimizerPrivate::collectReferences(const QByteArray& Svg,
+	QSet<QString>& References)
+{
+	static const QRegularExpression UrlReference("url\\(\\s*['\"]?#([^)'\"\\s]+)");
+	QXmlStreamReader Reader(Svg);
+	while (!Reader.atEnd())
+	{
+		Reader.readNext();
+		if (!Reader.isStartElement())
+		{
+			continue;
+		}
+
+		// Id selectors in style elements can not be resolved here
+		if (Reader.name() == QLatin1String("style"))
+		{
+			return false;
+		}
+
+		for (const auto& Attribute : Reader.attributes())
+		{
+			const auto Value = Attribute.value().toString();
+			if (Attribute.name() == QLatin1String("href") && Value.startsWith('#'))
+			{
+				References.insert(Value.mid(1));
+				continue;
+			}
+
+			auto it = UrlReference.globalMatch(Value);
+			while (it.hasNext())
+			{
+				References.insert(it.next().captured(1));
+			}
+		}
+	}
+	return !Reader.hasError();
+}
+
+
+//============================================================================
+QString SvgOptimizerPrivate::roundNumbers(const QString& Value) const
+{
+	static const QRegularExpression Number("-?(\\d*)\\.\\d+(?:[eE][-+]?\\d+)?");
+	QString Result;
+	int Pos = 0;
+	auto it = Number.globalMatch(Value);
+	while (it.hasNext())
+	{
+		const auto Match = it.next();
+		const int Start = Match.capturedStart();
+		const int End = Match.capturedEnd();
+		Result += Value.mid(Pos, Start - Pos);
+
+		auto Rounded = QString::number(Match.captured(0).toDouble(), 'f', Precision);
+		while (Rounded.endsWith('0'))
+		{
+			Rounded.chop(1);
+		}
+		if (Rounded.endsWith('.'))
+		{
+			Rounded.chop(1);
+		}
+
+		// In compact path data like "1.5.5", the decimal point separates the
+		// numbers. We keep numbers without leading zero in that format and
+		// insert spaces, if a number loses its decimal point.
+		const bool HasLeadingDigits = !Match.captured(1).isEmpty();
+		if (!HasLeadingDigits)
+		{
+			if (Rounded.startsWith("0."))
+			{
+				Rounded.remove(0, 1);
+			}
+			else if (Rounded.startsWith("-0."))
+			{
+				Rounded.remove(1, 1);
+			}
+		}
+		const bool HasPoint = Rounded.contains('.');
+		if (!HasPoint && Start > 0 && !Rounded.startsWith('-')
+		 && (Value.at(Start - 1).isDigit() || Value.at(Start - 1) == '.'))
+		{
+			Rounded.prepend(' ');
+		}
+		if (!HasPoint && End < Value.size() && Value.at(End) == '.')
+		{
+			Rounded += ' ';
+		}
+
+		Result += Rounded;
+		Pos = End;
+	}
+	Result += Value.mid(Pos);
+	return Result;
+}
+
+
+//============================================================================
+bool SvgOptimizerPrivate::writeOptimized(const QByteArray& Svg, QByteArray& Result) const
+{
+	QSet<QString> References;
+	const bool RemoveUnused = Options.testFlag(CSvgOptimizer::RemoveUnusedDefs)
+		&& collectReferences(Svg, References);
+	const bool StripMetadata = Options.testFlag(CSvgOptimizer::StripMetadata);
+	const bool StripComments = Options.testFlag(CSvgOptimizer::StripComments);
+
+	QXmlStreamReader Reader(Svg);
+	QXmlStreamWriter Writer(&Result);
+	Writer.setAutoFormatting(false);
+	QVector<OpenElement> Elements;
+	int SkipDepth = 0;
+	int TextDepth = 0;
+	while (!Reader.atEnd())
+	{
+		switch (Reader.readNext())
+		{
+		case QXmlStreamReader::StartElement:
+		{
+			const auto Name = Reader.qualifiedName().toString();
+			const bool InDefs = !Elements.isEmpty() && Elements.last().IsDefs;
+			const auto Attributes = Reader.attributes();
+			const auto Id = Attributes.value(QLatin1String("id")).toString();
+			if (SkipDepth
+			 || (StripMetadata && (Name == QLatin1String("metadata") || isEditorName(Name)))
+			 || (RemoveUnused && InDefs && !Id.isEmpty() && !References.contains(Id)))
+			{
+				SkipDepth++;
+				break;
+			}
+
+			QVector<QPair<QString, QString>> WrittenAttributes;
+			for (const auto& Declaration : Reader.namespaceDeclarations())
+			{
+				const auto Prefix = Declaration.prefix().toString();
+				const auto QualifiedName = Prefix.isEmpty() ? QString("xmlns") : "xmlns:" + Prefix;
+				if (!StripMetadata || !isEditorName(QualifiedName))
+				{
+					WrittenAttributes.append({QualifiedName, Declaration.namespaceUri().toString()});
+				}
+			}
+			for (const auto& Attribute : Attributes)
+			{
+				const auto AttributeName = Attribute.qualifiedName().toString();
+				auto Value = Attribute.value().toString();
+				if ((StripMetadata && isEditorName(AttributeName))
+				 || (RemoveUnused && AttributeName == QLatin1String("id") && !References.contains(Value)))
+				{
+					continue;
+				}
+				if (Options.testFlag(CSvgOptimizer::RoundNumbers))
+				{
+					for (auto GeometryAttribute : GeometryAttributes)
+					{
+						if (AttributeName == QLatin1String(GeometryAttribute))
+						{
+							Value = roundNumbers(Value);
+							break;
+						}
+					}
+				}
+				WrittenAttributes.append({AttributeName, Value});
+			}
+
+			OpenElement Element {true, Name == QLatin1String("defs"),
+				Name == QLatin1String("text")};
+			if (Options.testFlag(CSvgOptimizer::CollapseGroups)
+			 && Name == QLatin1String("g") && WrittenAttributes.isEmpty())
+			{
+				Element.Written = false;
+			}
+			else
+			{
+				Writer.writeStartElement(Name);
+				for (const auto& Attribute : WrittenAttributes)
+				{
+					Writer.writeAttribute(Attribute.first, Attribute.second);
+				}
+			}
+			TextDepth += Element.IsText ? 1 : 0;
+			Elements.append(Element);
+		}
+		break;
+
+		case QXmlStreamReader::EndElement:
+			if (SkipDepth)
+			{
+				SkipDepth--;
+				break;
+			}
+			if (Elements.last().Written)
+			{
+				Writer.writeEndElement();
+			}
+			TextDepth -= Elements.last().IsText ? 1 : 0;
+			Elements.removeLast();
+			break;
+
+		case QXmlStreamReader::Characters:
+			// Whitespace between elements is not required - only in text
+			// elements it is part of the content
+			if (SkipDepth || (StripComments && Reader.isWhitespace() && !TextDepth))
+			{
+				break;
+			}
+			if (Reader.isCDATA())
+			{
+				Writer.writeCDATA(Reader.text().toString());
+			}
+			else
+			{
+				Writer.writeCharacters(Reader.text().toString());
+			}
+			break;
+
+		case QXmlStreamReader::Comment:
+			if (!SkipDepth && !StripComments)
+			{
+				Writer.writeComment(Reader.text().toString());
+			}
+			break;
+
+		case QXmlStreamReader::ProcessingInstruction:
+			if (!SkipDepth && !StripComments)
+			{
+				Writer.writeProcessingInstruction(Reader.processingInstructionTarget().toString(),
+					Reader.processingInstructionData().toString());
+			}
+			break;
+
+		case QXmlStreamReader::DTD:
+			Writer.writeDTD(Reader.text().toString());
+			break;
+
+		case QXmlStreamReader::EntityReference:
+			if (!SkipDepth)
+			{
+				Writer.writeEntityReference(Reader.name().toString());
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	return !Reader.hasError();
+}
+
+
+//============================================================================
+QString CSvgOptimizer::Statistics::toString() const
+{
+	const double Percent = InputBytes ? (100.0 * savedBytes() / InputBytes) : 0;
+	auto Result = QString("%1 SVG files optimized: %2 bytes -> %3 bytes (%4 % saved)")
+		.arg(Files).arg(InputBytes).arg(OutputBytes).arg(Percent, 0, 'f', 1);
+	if (FailedFiles)
+	{
+		Result += QString(", %1 files kept unchanged").arg(FailedFiles);
+	}
+	return Result;
+}
+
+
+//============================================================================
+CSvgOptimizer::CSvgOptimizer(Options Options, int Precision) :
+	d(new SvgOptimizerPrivate(this))
+{
+	d->Options = Options;
+	d->Precision = Precision;
+}
+
+
+//============================================================================
+CSvgOptimizer::~CSvgOptimizer()
+{
+	delete d;
+}
+
+
+//============================================================================
+QByteArray CSvgOptimizer::optimize(const QByteArray& Svg)
+{
+	QByteArray Result;
+	Result.reserve(Svg.size());
+	d->Statistics.Files++;
+	d->Statistics.InputBytes += Svg.size();
+	const bool Valid = d->writeOptimized(Svg, Result);
+	if (!Valid || Result.size() >= Svg.size())
+	{
+		d->Statistics.FailedFiles += Valid ? 0 : 1;
+		d->Statistics.OutputBytes += Svg.size();
+		return Svg;
+	}
+
+	d->Statistics.OutputBytes += Result.size();
+	return Result;
+}
+
+
+//============================================================================
+const CSvgOptimizer::Statistics& CSvgOptimizer::statistics() const
+{
+	return d->Statistics;
+}
+
+
+//============================================================================
+void CSvgOptimizer::resetStatistics()
+{
+	d->Statistics = Statistics();
+}
+} // namespace acss
+
+//---------------------------------------------------------------------------
+// EOF SvgOptimizer.cpp
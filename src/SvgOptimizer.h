@@ -0,0 +1,127 @@
+#ifndef SvgOptimizerH
+#define SvgOptimizerH
+/*******************************************************************************
+** Qt Advanced Stylesheets
+** Copyright (C) 2022 Uwe Kindler
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+
+//============================================================================
+/// \file   SvgOptimizer.h
+/// \author Uwe Kindler
+/// \date   19.10.2026
+/// \brief  Declaration of CSvgOptimizer class
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include <QByteArray>
+#include <QFlags>
+#include <QString>
+
+#include "acss_globals.h"
+
+
+namespace acss
+{
+struct SvgOptimizerPrivate;
+
+/**
+ * Removes everything from SVG files that is not required for rendering.
+ * Icons exported from editors like Inkscape contain editor metadata,
+ * comments, unused definitions and coordinates with many decimal places.
+ * QSvgRenderer needs to parse all of this on each load. The optimizer
+ * keeps the colors untouched, so the color replacement of resource
+ * templates works on optimized SVG data, too.
+ * The optimizer accumulates the size savings of all optimized files.
+ */
+class ACSS_EXPORT CSvgOptimizer
+{
+private:
+	SvgOptimizerPrivate* d; ///< private data (pimpl)
+	friend struct SvgOptimizerPrivate;
+	Q_DISABLE_COPY(CSvgOptimizer)
+
+public:
+	/**
+	 * The optimizations
+	 */
+	enum eOption
+	{
+		StripMetadata = 0x01,///< metadata elements and editor namespaces
+		StripComments = 0x02,///< comments, processing instructions and whitespace
+		RemoveUnusedDefs = 0x04,///< unreferenced definitions and ids
+		CollapseGroups = 0x08,///< groups without attributes
+		RoundNumbers = 0x10,///< coordinates and lengths of the geometry
+		AllOptions = 0x1f
+	};
+	Q_DECLARE_FLAGS(Options, eOption)
+
+	/**
+	 * The accumulated size savings
+	 */
+	struct Statistics
+	{
+		int Files = 0;
+		int FailedFiles = 0;///< files that could not be parsed and are kept
+		qint64 InputBytes = 0;
+		qint64 OutputBytes = 0;
+
+		/**
+		 * Returns the number of bytes that have been removed
+		 */
+		qint64 savedBytes() const {return InputBytes - OutputBytes;}
+
+		/**
+		 * Returns a one line summary of the savings
+		 */
+		QString toString() const;
+	};
+
+	/**
+	 * Creates an optimizer with the given options. Numbers are rounded to
+	 * the given number of decimal places.
+	 */
+	CSvgOptimizer(Options Options = AllOptions, int Precision = 3);
+
+	/**
+	 * Virtual Destructor
+	 */
+	virtual ~CSvgOptimizer();
+
+	/**
+	 * Returns the optimized SVG data. If the data is not a valid XML
+	 * document, the function returns the unchanged data.
+	 */
+	QByteArray optimize(const QByteArray& Svg);
+
+	/**
+	 * Returns the accumulated statistics of all optimize() calls
+	 */
+	const Statistics& statistics() const;
+
+	/**
+	 * Clears the statistics
+	 */
+	void resetStatistics();
+}; // class CSvgOptimizer
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(CSvgOptimizer::Options)
+} // namespace acss
+
+//---------------------------------------------------------------------------
+#endif // SvgOptimizerH
@@ -0,0 +1,156 @@
+/*******************************************************************************
+** Qt Advanced Stylesheets
+** Copyright (C) 2022 Uwe Kindler
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+
+//============================================================================
+/// \file   ThemeSnapshot.cpp
+/// \author Uwe Kindler
+/// \date   19.10.2026
+/// \brief  Implementation of CThemeSnapshot class
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include "ThemeSnapshot.h"
+
+#include <QHash>
+
+
+namespace acss
+{
+/**
+ * Private data class of CThemeSnapshot class (pimpl)
+ */
+struct ThemeSnapshotPrivate
+{
+	int Generation = 0;
+	QString Style;
+	QString Theme;
+	bool IsDark = false;
+	QMap<QString, QString> Variables;
+	QHash<QString, QColor> Colors;///< theme colors with valid color values
+	QPalette Palette;
+	QVector<QPair<QString, QString>> IconColorReplaceList;
+};// struct ThemeSnapshotPrivate
+
+
+//============================================================================
+CThemeSnapshot::CThemeSnapshot() :
+	d(new ThemeSnapshotPrivate())
+{
+
+}
+
+
+//============================================================================
+CThemeSnapshot::CThemeSnapshot(int Generation, const QString& Style,
+	const QString& Theme, bool IsDark, const QMap<QString, QString>& Variables,
+	const QMap<QString, QString>& ThemeColors, const QPalette& Palette, const QVector<QPair<QString, QString>>& IconColorReplaceList) :
+	d(new ThemeSnapshotPrivate())
+{
+	d->Generation = Generation;
+	d->Style = Style;
+	d->Theme = Theme;
+	d->IsDark = IsDark;
+	d->Variables = Variables;
+	d->Palette = Palette;
+	d->IconColorReplaceList = IconColorReplaceList;
+	for (auto it = ThemeColors.constBegin(); it != ThemeColors.constEnd(); ++it)
+	{
+		QColor Color(it.value());
+		if (Color.isValid())
+		{
+			d->Colors.insert(it.key(), Color);
+		}
+	}
+}
+
+
+//============================================================================
+CThemeSnapshot::~CThemeSnapshot()
+{
+	delete d;
+}
+
+
+//============================================================================
+int CThemeSnapshot::generation() const
+{
+	return d->Generation;
+}
+
+
+//============================================================================
+QString CThemeSnapshot::style() const
+{
+	return d->Style;
+}
+
+
+//============================================================================
+QString CThemeSnapshot::theme() const
+{
+	return d->Theme;
+}
+
+
+//============================================================================
+bool CThemeSnapshot::isDark() const
+{
+	return d->IsDark;
+}
+
+
+//============================================================================
+const QMap<QString, QString>& CThemeSnapshot::variables() const
+{
+	return d->Variables;
+}
+
+
+//============================================================================
+QString CThemeSnapshot::variableValue(const QString& VariableId) const
+{
+	return d->Variables.value(VariableId);
+}
+
+
+//============================================================================
+QColor CThemeSnapshot::color(const QString& VariableId) const
+{
+	return d->Colors.value(VariableId);
+}
+
+
+//============================================================================
+const QPalette& CThemeSnapshot::palette() const
+{
+	return d->Palette;
+}
+
+
+//============================================================================
+const QVector<QPair<QString, QString>>& CThemeSnapshot::iconColorReplaceList() const
+{
+	return d->IconColorReplaceList;
+}
+} // namespace acss
+
+//---------------------------------------------------------------------------
+// EOF ThemeSnapshot.cpp
@@ -0,0 +1,140 @@
+#ifndef ThemeSnapshotH
+#define ThemeSnapshotH
+/*******************************************************************************
+** Qt Advanced Stylesheets
+** Copyright (C) 2022 Uwe Kindler
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+
+//============================================================================
+/// \file   ThemeSnapshot.h
+/// \author Uwe Kindler
+/// \date   19.10.2026
+/// \brief  Declaration of CThemeSnapshot class
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include <QColor>
+#include <QMap>
+#include <QPair>
+#include <QPalette>
+#include <QString>
+#include <QVector>
+
+#include <memory>
+
+#include "acss_globals.h"
+
+
+namespace acss
+{
+struct ThemeSnapshotPrivate;
+struct QtAdvancedStylesheetPrivate;
+
+/**
+ * Immutable copy of a committed theme state.
+ * QtAdvancedStylesheet publishes a new snapshot each time
+ * updateStylesheet() applied changes. A snapshot never changes after it
+ * has been published, so all functions may be called from any thread
+ * without locking. Use QtAdvancedStylesheet::themeSnapshot() to get the
+ * current snapshot.
+ */
+class ACSS_EXPORT CThemeSnapshot
+{
+private:
+	ThemeSnapshotPrivate* d; ///< private data (pimpl)
+	friend struct ThemeSnapshotPrivate;
+	friend struct QtAdvancedStylesheetPrivate;
+	Q_DISABLE_COPY(CThemeSnapshot)
+
+	/**
+	 * Creates a snapshot with the given theme state. The colors are parsed
+	 * from the values of the theme colors.
+	 */
+	CThemeSnapshot(int Generation, const QString& Style, const QString& Theme,
+		bool IsDark, const QMap<QString, QString>& Variables,
+		const QMap<QString, QString>& ThemeColors, const QPalette& Palette,
+		const QVector<QPair<QString, QString>>& IconColorReplaceList);
+
+public:
+	/**
+	 * Creates an empty snapshot
+	 */
+	CThemeSnapshot();
+
+	/**
+	 * Virtual Destructor
+	 */
+	virtual ~CThemeSnapshot();
+
+	/**
+	 * Returns the generation of this snapshot. Each published snapshot
+	 * has a higher generation than the previous one. The empty snapshot
+	 * that is available before the first update has the generation 0.
+	 */
+	int generation() const;
+
+	/**
+	 * Returns the style of this snapshot
+	 */
+	QString style() const;
+
+	/**
+	 * Returns the theme of this snapshot
+	 */
+	QString theme() const;
+
+	/**
+	 * Returns true, if the theme is a dark theme
+	 */
+	bool isDark() const;
+
+	/**
+	 * Returns all theme variables - the style variables and theme colors
+	 */
+	const QMap<QString, QString>& variables() const;
+
+	/**
+	 * Returns the value of the given theme variable or an empty string
+	 */
+	QString variableValue(const QString& VariableId) const;
+
+	/**
+	 * Returns the parsed color of the given theme color or an invalid
+	 * color, if the variable is not a theme color - like
+	 * QtAdvancedStylesheet::themeColor()
+	 */
+	QColor color(const QString& VariableId) const;
+
+	/**
+	 * Returns the theme palette
+	 */
+	const QPalette& palette() const;
+
+	/**
+	 * Returns the color replace list for theme aware icons. Each entry
+	 * contains the template color and the theme color.
+	 */
+	const QVector<QPair<QString, QString>>& iconColorReplaceList() const;
+}; // class CThemeSnapshot
+
+using tThemeSnapshotPtr = std::shared_ptr<const CThemeSnapshot>;
+} // namespace acss
+
+//---------------------------------------------------------------------------
+#endif // ThemeSnapshotH
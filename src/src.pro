@@ -5,7 +5,7 @@ TARGET = $$qtLibraryTarget(qtadvancedcss)
 DEFINES += QT_DEPRECATED_WARNINGS
 TEMPLATE = lib
 DESTDIR = $${ACSS_OUT_ROOT}/lib
-QT += core gui widgets qml svg
+QT += core gui widgets svg concurrent
 
 !acssBuildStatic {
 	CONFIG += shared
@@ -31,13 +31,38 @@ windows {
 
 HEADERS += \
     acss_globals.h \
-	QmlStyleUrlInterceptor.h \
-	QtAdvancedStylesheet.h
+	CompiledStyle.h \
+	QtAdvancedStylesheet.h \
+	SharedIconCache.h \
+	StylePolishProfiler.h \
+	StylesheetAnalyzer.h \
+	SvgOptimizer.h \
+	ThemeSnapshot.h
 
 
 SOURCES += \
-	QmlStyleUrlInterceptor.cpp \
-	QtAdvancedStylesheet.cpp
+	QtAdvancedStylesheet.cpp \
+	SharedIconCache.cpp \
+	StylePolishProfiler.cpp \
+	StylesheetAnalyzer.cpp \
+	SvgOptimizer.cpp \
+	ThemeSnapshot.cpp
+
+# The QML support links QtQml and QtQuick. Widget only applications can
+# build the library without it via CONFIG += acssNoQml
+!acssNoQml {
+	QT += qml quick
+
+	HEADERS += \
+		QmlStyleUrlInterceptor.h \
+		QmlStyleImageProvider.h \
+		QmlStyleTheme.h
+
+	SOURCES += \
+		QmlStyleUrlInterceptor.cpp \
+		QmlStyleImageProvider.cpp \
+		QmlStyleTheme.cpp
+}
 
 
 isEmpty(PREFIX){
@@ -0,0 +1,29 @@
+ACSS_OUT_ROOT = $${OUT_PWD}/../..
+
+QT += core gui widgets
+
+TARGET = acss_stylec
+DESTDIR = $${ACSS_OUT_ROOT}/lib
+TEMPLATE = app
+
+CONFIG += c++14
+CONFIG += debug_and_release
+CONFIG += console
+CONFIG -= app_bundle
+
+acssBuildStatic {
+    DEFINES += ACSS_STATIC
+}
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += main.cpp
+
+# The tool runs during the build - so it needs to find the library without
+# any installation
+QMAKE_RPATHDIR += $${ACSS_OUT_ROOT}/lib
+
+LIBS += -L$${ACSS_OUT_ROOT}/lib
+include(../../acss.pri)
+INCLUDEPATH += ../../src
+DEPENDPATH += ../../src
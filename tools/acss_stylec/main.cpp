@@ -0,0 +1,83 @@
+//============================================================================
+/// \file   main.cpp
+/// \author Uwe Kindler
+/// \date   19.10.2026
+/// \brief  Style compiler that generates C++ sources from a style folder
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include <QtAdvancedStylesheet.h>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFileInfo>
+#include <QDir>
+#include <QSaveFile>
+
+#include <iostream>
+
+using namespace acss;
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCommandLineParser Parser;
+    Parser.setApplicationDescription("Compiles a style folder into a C++ "
+        "source file that defines an acss::CompiledStyle");
+    Parser.addHelpOption();
+    QCommandLineOption IdentifierOption("identifier", "Name of the generated "
+        "acss::CompiledStyle variable. The default is <style>_style.", "name");
+    QCommandLineOption NoFontsOption("no-fonts", "Do not embed the style fonts");
+    QCommandLineOption VariablesHeaderOption("variables-header", "Generate a "
+        "header with typed ids for the theme variables instead of the compiled "
+        "style. The identifier is the namespace of the ids. The default is "
+        "<style>_variables.");
+    Parser.addOption(IdentifierOption);
+    Parser.addOption(NoFontsOption);
+    Parser.addOption(VariablesHeaderOption);
+    Parser.addPositionalArgument("style", "The style folder - e.g. styles/qt_material");
+    Parser.addPositionalArgument("output", "The generated C++ source or header file");
+    Parser.process(a);
+
+    const auto Args = Parser.positionalArguments();
+    if (Args.size() != 2)
+    {
+        Parser.showHelp(1);
+    }
+
+    // The style is loaded with the same code that loads it at runtime
+    QFileInfo StyleDir(Args[0]);
+    QtAdvancedStylesheet AdvancedStylesheet;
+    AdvancedStylesheet.setStylesDirPath(StyleDir.absolutePath());
+    if (!AdvancedStylesheet.setCurrentStyle(StyleDir.fileName()))
+    {
+        std::cerr << "acss_stylec: " << qPrintable(AdvancedStylesheet.errorString()) << std::endl;
+        return 1;
+    }
+
+    const bool VariablesHeader = Parser.isSet(VariablesHeaderOption);
+    QString Identifier = Parser.value(IdentifierOption);
+    if (Identifier.isEmpty())
+    {
+        Identifier = StyleDir.fileName() + (VariablesHeader ? "_variables" : "_style");
+    }
+
+    // QSaveFile ensures that the build never sees half written sources
+    QSaveFile Output(Args[1]);
+    if (!Output.open(QIODevice::WriteOnly))
+    {
+        std::cerr << "acss_stylec: " << qPrintable(Output.errorString()) << std::endl;
+        return 1;
+    }
+
+    const bool Result = VariablesHeader
+        ? AdvancedStylesheet.compileThemeVariableIds(Output, Identifier)
+        : AdvancedStylesheet.compileCurrentStyle(Output, Identifier, !Parser.isSet(NoFontsOption));
+    if (!Result || !Output.commit())
+    {
+        std::cerr << "acss_stylec: " << qPrintable(AdvancedStylesheet.errorString()) << std::endl;
+        return 1;
+    }
+    return 0;
+}